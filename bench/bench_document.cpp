@@ -0,0 +1,344 @@
+#include <cppjson/Document.hpp>
+#include <cppjson/TapeDocument.hpp>
+#include <cppjson/LazyDocument.hpp>
+#include <cppjson/PathFilter.hpp>
+#include <cppjson/ParallelArrayReader.hpp>
+#include <cppjson/MemoryReadStream.hpp>
+#include <cppjson/Writer.hpp>
+#include <cppjson/PrettyWriter.hpp>
+#include <cppjson/StringWriteStream.hpp>
+#include "generate.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+
+using namespace cppjson;
+
+// every heap allocation of the process is counted
+// the whole new/delete set is replaced, so that every delete frees what the matching new malloc'ed
+static size_t g_allocations = 0;
+
+static void* countedAllocate(size_t size) {
+    g_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) {
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size) {
+    return countedAllocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// touches every scalar, so that both trees are fully walked
+static size_t visit(const Value& value) {
+    switch (value.getType()) {
+        case TYPE_STRING:
+            return value.getStringLength();
+        case TYPE_ARRAY: {
+            size_t sum = 0;
+            for (auto& element : value.getArray()) {
+                sum += visit(element);
+            }
+            return sum;
+        }
+        case TYPE_OBJECT: {
+            size_t sum = 0;
+            for (auto& member : value.getObject()) {
+                sum += visit(member.m_value);
+            }
+            return sum;
+        }
+        case TYPE_INT32:
+            return static_cast<size_t>(value.getInt32());
+        default:
+            return 1;
+    }
+}
+
+static size_t visit(const TapeValue& value) {
+    switch (value.getType()) {
+        case TYPE_STRING:
+            return value.getStringLength();
+        case TYPE_ARRAY: {
+            size_t sum = 0;
+            for (auto& element : value.getArray()) {
+                sum += visit(element);
+            }
+            return sum;
+        }
+        case TYPE_OBJECT: {
+            size_t sum = 0;
+            for (auto& member : value.getObject()) {
+                sum += visit(member.m_value);
+            }
+            return sum;
+        }
+        case TYPE_INT32:
+            return static_cast<size_t>(value.getInt32());
+        default:
+            return 1;
+    }
+}
+
+// reads a single member of every record, the rest of the document is not looked at
+template <typename V>
+static size_t pick(const V& root, const std::string& key) {
+    size_t found = 0;
+    for (auto& element : root.getArray()) {
+        if (element.findMember(key) != element.getObject().end()) {
+            found++;
+        }
+    }
+    return found;
+}
+
+struct Result {
+    double parseMBs;
+    double visitMBs;
+    double allocationsPerParse;
+};
+
+// fresh: a new document per parse, otherwise one document is reused
+template <typename Doc, typename Root>
+static Result run(const std::string& json, int iterations, bool fresh, Root root) {
+    std::unique_ptr<Doc> doc(new Doc);
+    std::chrono::duration<double> parseTime(0), visitTime(0);
+    size_t allocations = 0, sum = 0;
+    for (int i = 0; i < iterations; i++) {
+        if (fresh && i > 0) {
+            doc.reset(new Doc);
+        }
+        size_t before = g_allocations;
+        auto begin = std::chrono::steady_clock::now();
+        if (doc->parse(json.data(), json.size()) != PARSE_OK) {
+            fputs("parse error\n", stderr);
+            exit(1);
+        }
+        auto parsed = std::chrono::steady_clock::now();
+        allocations += g_allocations - before;
+        sum += visit(root(*doc));
+        visitTime += std::chrono::steady_clock::now() - parsed;
+        parseTime += parsed - begin;
+    }
+    if (sum == 0) {
+        fputs("empty document\n", stderr);
+    }
+    double bytes = json.size() * static_cast<double>(iterations) / (1024 * 1024);
+    return Result{bytes / parseTime.count(), bytes / visitTime.count(), allocations / static_cast<double>(iterations)};
+}
+
+// parse + pick, in MB/s
+template <typename Doc, typename Root>
+static double runPick(const std::string& json, int iterations, bool fresh, Root root, const std::string& key) {
+    std::unique_ptr<Doc> doc(new Doc);
+    size_t found = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        if (fresh && i > 0) {
+            doc.reset(new Doc);
+        }
+        if (doc->parse(json.data(), json.size()) != PARSE_OK) {
+            fputs("parse error\n", stderr);
+            exit(1);
+        }
+        found += pick(root(*doc), key);
+    }
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - begin;
+    if (found == 0) {
+        fputs("key not found\n", stderr);
+    }
+    return json.size() * static_cast<double>(iterations) / (1024 * 1024) / time.count();
+}
+
+// a small Document built from two records of the input, in MB/s
+static double runFilter(const std::string& json, int iterations, const PathFilter& filter) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        Document doc;
+        MemoryReadStream is(json.data(), json.size());
+        if (filter.parse(is, doc) != PARSE_OK || doc.getSize() == 0) {
+            fputs("filter error\n", stderr);
+            exit(1);
+        }
+    }
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - begin;
+    return json.size() * static_cast<double>(iterations) / (1024 * 1024) / time.count();
+}
+
+static void report(const char* name, const std::string& json, int iterations) {
+    // a new Document per parse, a TapeDocument keeps its buffers between parses
+    Result tree = run<Document>(json, iterations, true, [](Document& doc) -> const Value& { return doc; });
+    Result tape = run<TapeDocument>(json, iterations, false, [](TapeDocument& doc) { return doc.root(); });
+    printf("%-10s %9zu bytes  Document parse %7.1f MB/s visit %8.1f MB/s %9.0f allocs"
+           "  TapeDocument parse %7.1f MB/s visit %8.1f MB/s %9.0f allocs\n",
+           name, json.size(), tree.parseMBs, tree.visitMBs, tree.allocationsPerParse,
+           tape.parseMBs, tape.visitMBs, tape.allocationsPerParse);
+}
+
+// LazyDocument only pays for the member it reads, the other values are skipped
+static void reportPick(const char* name, const std::string& json, int iterations, const std::string& key) {
+    double tree = runPick<Document>(json, iterations, true, [](Document& doc) -> const Value& { return doc; }, key);
+    double tape = runPick<TapeDocument>(json, iterations, false, [](TapeDocument& doc) { return doc.root(); }, key);
+    double lazy = runPick<LazyDocument>(json, iterations, false, [](LazyDocument& doc) { return doc.root(); }, key);
+    printf("%-10s pick \"%s\"  Document %7.1f MB/s  TapeDocument %7.1f MB/s  LazyDocument %7.1f MB/s\n",
+           name, key.c_str(), tree, tape, lazy);
+
+    PathFilter filter;
+    filter.add("/1/" + key);
+    filter.add("/100");
+    printf("%-10s filter /1/%s /100 into a Document %7.1f MB/s\n", name, key.c_str(), runFilter(json, iterations, filter));
+}
+
+// the root array parsed on every core, against one thread
+static void reportParallel(const char* name, const std::string& json, int iterations) {
+    ParallelArrayReader reader;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        Document doc;
+        if (reader.parse(json.data(), json.size(), doc) != PARSE_OK) {
+            fputs("parse error\n", stderr);
+            exit(1);
+        }
+    }
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - begin;
+    double bytes = json.size() * static_cast<double>(iterations) / (1024 * 1024);
+    printf("%-10s ParallelArrayReader (%zu threads) parse %7.1f MB/s\n", name, reader.getThreadCount(), bytes / time.count());
+}
+
+// findMember in one object of many keys, e.g. a dictionary
+static void reportLookup(size_t keys, int iterations) {
+    std::string json = "{";
+    for (size_t i = 0; i < keys; i++) {
+        json += (i ? ",\"" : "\"") + ("user_" + std::to_string(i)) + "\":" + std::to_string(i);
+    }
+    json += "}";
+    Document doc;
+    if (doc.parse(json) != PARSE_OK) {
+        fputs("parse error\n", stderr);
+        exit(1);
+    }
+    size_t found = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (size_t k = 0; k < keys; k += 7) {
+            found += doc.findMember("user_" + std::to_string(k)) != doc.getObject().end();
+        }
+    }
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - begin;
+    printf("%zu keys   findMember %8.1f ns\n", keys, time.count() * 1e9 / static_cast<double>(found));
+}
+
+// copies of a parsed tree (e.g. a config handed to every request), one of its values changed in each
+static void reportCopy(const char* name, const std::string& json, int iterations) {
+    Document doc;
+    if (doc.parse(json.data(), json.size()) != PARSE_OK) {
+        fputs("parse error\n", stderr);
+        exit(1);
+    }
+    size_t before = g_allocations;
+    auto begin = std::chrono::steady_clock::now();
+    Value tree(doc);//和doc共享MemoryPool里的块
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - begin;
+    printf("%-10s copy out of the pool %10.2f us %9zu allocs\n", name, time.count() * 1e6, g_allocations - before);
+    size_t sum = 0;
+    for (bool change : {false, true}) {
+        size_t before = g_allocations;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            Value copy(tree);
+            if (change) {
+                copy[0]["id"].setInt32(i);
+            }
+            sum += copy.getSize();
+        }
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - begin;
+        printf("%-10s copy%-9s %10.2f us %9.0f allocs\n", name, change ? " + change" : "", time.count() * 1e6 / iterations,
+               (g_allocations - before) / static_cast<double>(iterations));
+    }
+    if (sum == 0) {
+        fputs("empty document\n", stderr);
+    }
+}
+
+// records whose keys are longer than a short string, their keys copied into each document or shared in a KeyPool
+static void reportKeyPool(size_t records, int iterations) {
+    std::string json = "[";
+    for (size_t r = 0; r < records; r++) {
+        json += r ? ",{" : "{";
+        for (size_t i = 0; i < 20; i++) {
+            json += (i ? ",\"" : "\"") + ("record_field_number_" + std::to_string(i)) + "\":" + std::to_string(r + i);
+        }
+        json += "}";
+    }
+    json += "]";
+    auto keys = std::make_shared<KeyPool>();
+    for (bool intern : {false, true}) {
+        size_t used = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            Document doc;
+            if (intern) {
+                doc.setKeyPool(keys);
+            }
+            if (doc.parse(json.data(), json.size()) != PARSE_OK) {
+                fputs("parse error\n", stderr);
+                exit(1);
+            }
+            used = doc.getUsedBytes();
+        }
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - begin;
+        double bytes = json.size() * static_cast<double>(iterations) / (1024 * 1024);
+        printf("long keys  %-8s parse %7.1f MB/s  %9zu bytes used in the document\n",
+               intern ? "KeyPool" : "copied", bytes / time.count(), used);
+    }
+}
+
+int main(int argc, char** argv) {
+    int records = argc > 1 ? atoi(argv[1]) : 20000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 10;
+
+    StringWriteStream minified;
+    Writer<StringWriteStream> writer(minified);
+    generate(writer, records);
+
+    StringWriteStream strings;
+    Writer<StringWriteStream> stringWriter(strings);
+    generateStrings(stringWriter, records);
+
+    report("minified", minified.get(), iterations);
+    report("strings", strings.get(), iterations);
+    reportPick("minified", minified.get(), iterations, "id");
+    reportPick("strings", strings.get(), iterations, "level");
+    reportParallel("minified", minified.get(), iterations);
+    reportParallel("strings", strings.get(), iterations);
+    reportLookup(10, iterations * 1000);
+    reportLookup(5000, iterations);
+    reportKeyPool(records, iterations);
+    reportCopy("minified", minified.get(), iterations);
+    return 0;
+}
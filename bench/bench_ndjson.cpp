@@ -0,0 +1,73 @@
+#include <cppjson/Document.hpp>
+#include <cppjson/NdjsonReader.hpp>
+#include <cppjson/TapeDocument.hpp>
+#include <cppjson/Writer.hpp>
+#include <cppjson/StringWriteStream.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+using namespace cppjson;
+
+// log lines: a few fields and a message per line
+static std::string generateLines(int lines) {
+    std::string json;
+    for (int i = 0; i < lines; i++) {
+        StringWriteStream os;
+        Writer<StringWriteStream> writer(os);
+        writer.StartObject();
+        writer.Key("ts");
+        writer.Int64(1700000000000LL + i);
+        writer.Key("level");
+        writer.String(i % 10 == 0 ? "warn" : "info");
+        writer.Key("message");
+        writer.String("GET /api/v1/items?page=" + std::to_string(i) + " took " + std::to_string(i % 97) + "ms");
+        writer.Key("tags");
+        writer.StartArray();
+        writer.String("web");
+        writer.Int32(i % 16);
+        writer.EndArray();
+        writer.EndObject();
+        json += os.get();
+        json += '\n';
+    }
+    return json;
+}
+
+template <typename Doc>
+static double run(const std::string& json, size_t threads, int iterations, bool ordered) {
+    NdjsonReader<Doc> reader(threads);
+    std::atomic<size_t> ok(0);
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        reader.parse(json.data(), json.size(), [&](size_t, ParseError err, Doc&) {
+            if (err == PARSE_OK) {
+                ok++;
+            }
+        }, ordered);
+    }
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - begin;
+    if (ok == 0) {
+        fputs("no document\n", stderr);
+    }
+    return json.size() * static_cast<double>(iterations) / (1024 * 1024) / time.count();
+}
+
+int main(int argc, char** argv) {
+    int lines = argc > 1 ? atoi(argv[1]) : 200000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    std::string json = generateLines(lines);
+    printf("%zu bytes, %d lines, %u cores\n", json.size(), lines, std::thread::hardware_concurrency());
+
+    for (size_t threads = 1; threads <= std::max(1u, std::thread::hardware_concurrency()) * 2; threads *= 2) {
+        printf("%2zu threads  Document ordered %7.1f MB/s unordered %7.1f MB/s"
+               "  TapeDocument ordered %7.1f MB/s unordered %7.1f MB/s\n", threads,
+               run<Document>(json, threads, iterations, true), run<Document>(json, threads, iterations, false),
+               run<TapeDocument>(json, threads, iterations, true), run<TapeDocument>(json, threads, iterations, false));
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <cppjson/IndexReader.hpp>
+#include <cppjson/MemoryReadStream.hpp>
+#include <cppjson/PushReader.hpp>
+#include <cppjson/Writer.hpp>
+#include <cppjson/PrettyWriter.hpp>
+#include <cppjson/StringWriteStream.hpp>
+#include "generate.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using namespace cppjson;
+
+// counts events, so that the time measured is the Reader's own
+class NullHandler {
+public:
+    bool Null() { m_count++; return true; }
+    bool Bool(bool) { m_count++; return true; }
+    bool Int32(int32_t) { m_count++; return true; }
+    bool Int64(int64_t) { m_count++; return true; }
+    bool Double(double) { m_count++; return true; }
+    bool String(const char*, size_t, bool) { m_count++; return true; }
+    bool Key(const char*, size_t, bool) { m_count++; return true; }
+    bool StartArray() { m_count++; return true; }
+    bool EndArray() { m_count++; return true; }
+    bool StartObject() { m_count++; return true; }
+    bool EndObject() { m_count++; return true; }
+    size_t m_count = 0;
+};
+
+// hides getPtr() of MemoryReadStream, so whitespace and strings are read one byte at a time
+class ByteReadStream {
+public:
+    typedef MemoryReadStream::Iterator Iterator;
+    ByteReadStream(const char* json, size_t len) : m_is(json, len) {}
+    bool hasNext() { return m_is.hasNext(); }
+    char next() { return m_is.next(); }
+    char peek() { return m_is.peek(); }
+    Iterator getIter() { return m_is.getIter(); }
+    void assertNext(char ch) { m_is.assertNext(ch); }
+private:
+    MemoryReadStream m_is;
+};
+
+class IndexReaderEngine {
+public:
+    template <typename Handler>
+    ParseError parse(const std::string& json, Handler& handler) {
+        return m_reader.parse(json.data(), json.size(), handler);
+    }
+private:
+    IndexReader m_reader;
+};
+
+// the input arrives in 64 KiB chunks
+class PushReaderEngine {
+public:
+    template <typename Handler>
+    ParseError parse(const std::string& json, Handler& handler) {
+        const size_t chunkSize = 64 * 1024;
+        PushReader<Handler> reader(handler);
+        for (size_t i = 0; i < json.size(); i += chunkSize) {
+            reader.feed(json.data() + i, std::min(chunkSize, json.size() - i));
+        }
+        return reader.finish();
+    }
+};
+
+template <typename ReadStream>
+class ReaderEngine {
+public:
+    template <typename Handler>
+    ParseError parse(const std::string& json, Handler& handler) {
+        ReadStream is(json.data(), json.size());
+        return Reader::parse(is, handler);
+    }
+};
+
+template <typename Engine>
+static double run(const std::string& json, int iterations) {
+    Engine engine;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        NullHandler handler;
+        if (engine.parse(json, handler) != PARSE_OK) {
+            fputs("parse error\n", stderr);
+            exit(1);
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    return json.size() * static_cast<double>(iterations) / elapsed.count() / (1024 * 1024);
+}
+
+static void report(const char* name, const std::string& json, int iterations) {
+    size_t blanks = 0;
+    for (char ch : json) {
+        blanks += (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n');
+    }
+    double byteAtATime = run<ReaderEngine<ByteReadStream>>(json, iterations);
+    double bulk = run<ReaderEngine<MemoryReadStream>>(json, iterations);
+    double indexed = run<IndexReaderEngine>(json, iterations);
+    double push = run<PushReaderEngine>(json, iterations);
+    printf("%-10s %9zu bytes %5.1f%% blank  byte-at-a-time %7.1f MB/s  vectorized %7.1f MB/s  indexed %7.1f MB/s"
+           "  push %7.1f MB/s\n",
+           name, json.size(), 100.0 * blanks / json.size(), byteAtATime, bulk, indexed, push);
+}
+
+int main(int argc, char** argv) {
+    int records = argc > 1 ? atoi(argv[1]) : 20000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 10;
+
+    StringWriteStream minified;
+    Writer<StringWriteStream> writer(minified);
+    generate(writer, records);
+
+    StringWriteStream indented;
+    PrettyWriter<StringWriteStream> prettyWriter(indented);
+    generate(prettyWriter, records);
+
+    StringWriteStream strings;
+    Writer<StringWriteStream> stringWriter(strings);
+    generateStrings(stringWriter, records);
+
+    report("minified", minified.get(), iterations);
+    report("indented", indented.get(), iterations);
+    report("strings", strings.get(), iterations);
+    return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef CPPJSON_BENCH_GENERATE_HPP
+#define CPPJSON_BENCH_GENERATE_HPP
+
+#include <string>
+
+// inputs shared by the benchmarks, written through any Writer
+
+template <typename Writer>
+static void generate(Writer& writer, int records) {
+    writer.StartArray();
+    for (int i = 0; i < records; i++) {
+        writer.StartObject();
+        writer.Key("id");
+        writer.Int32(i);
+        writer.Key("name");
+        writer.String("item " + std::to_string(i));
+        writer.Key("tags");
+        writer.StartArray();
+        writer.String("a");
+        writer.String("b");
+        writer.EndArray();
+        writer.Key("nested");
+        writer.StartObject();
+        writer.Key("enabled");
+        writer.Bool(i % 2 == 0);
+        writer.Key("values");
+        writer.StartArray();
+        for (int j = 0; j < 4; j++) {
+            writer.Int32(i + j);
+        }
+        writer.EndArray();
+        writer.EndObject();
+        writer.EndObject();
+    }
+    writer.EndArray();
+}
+
+// log-like records dominated by long string values
+template <typename Writer>
+static void generateStrings(Writer& writer, int records) {
+    std::string message;
+    for (int i = 0; i < 8; i++) {
+        message += "GET /api/v1/items?page=" + std::to_string(i) + " took 12ms <a href='/x'>link</a> ";
+    }
+    writer.StartArray();
+    for (int i = 0; i < records; i++) {
+        writer.StartObject();
+        writer.Key("level");
+        writer.String("info");
+        writer.Key("message");
+        writer.String(message + std::to_string(i));
+        writer.Key("payload");
+        writer.String(std::string(256, 'A' + i % 26) + "\n" + std::string(64, '/'));
+        writer.EndObject();
+    }
+    writer.EndArray();
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include "BufferedFileReadStream.hpp"
+#include <cassert>
+#include <cstring>
+
+namespace cppjson {
+
+BufferedFileReadStream::BufferedFileReadStream(FILE* input, size_t bufferSize)
+    : m_input(input), m_buffer(bufferSize > 0 ? bufferSize : 1), m_offset(0), m_eof(false) {
+    m_iterator = m_end = m_buffer.data();
+    refill();
+}
+
+bool BufferedFileReadStream::refill() {
+    if (m_eof) {
+        return false;
+    }
+    size_t remain = m_end - m_iterator;
+    if (m_iterator != m_buffer.data()) {//未读的数据移到缓冲区开头
+        m_offset += m_iterator - m_buffer.data();
+        memmove(m_buffer.data(), m_iterator, remain);
+    } else if (remain == m_buffer.size()) {//缓冲区已满(一个很长的数字或字符串)
+        m_buffer.resize(m_buffer.size() * 2);
+    }
+    m_iterator = m_buffer.data();
+    m_end = m_iterator + remain;
+
+    size_t n = fread(m_buffer.data() + remain, 1, m_buffer.size() - remain, m_input);
+    if (n == 0) {//表示读取完了文件(或者出错)
+        m_eof = true;
+        return false;
+    }
+    m_end += n;
+    return true;
+}
+
+bool BufferedFileReadStream::hasNext() {
+    return m_iterator != m_end || refill();
+}
+
+char BufferedFileReadStream::next() {
+    if (hasNext()) {
+        return *m_iterator++;
+    }
+    return '\0';
+}
+
+char BufferedFileReadStream::peek() {
+    return hasNext() ? *m_iterator : '\0';
+}
+
+BufferedFileReadStream::Iterator BufferedFileReadStream::getIter() {
+    return m_offset + (m_iterator - m_buffer.data());
+}
+
+size_t BufferedFileReadStream::tell() {
+    return getIter();
+}
+
+void BufferedFileReadStream::assertNext(char ch) {
+    char c = next();//NDEBUG下也要读取
+    assert(c == ch);
+    (void)c; (void)ch;
+}
+
+const char* BufferedFileReadStream::getPtr() {
+    return m_iterator;
+}
+
+const char* BufferedFileReadStream::getEnd() {
+    return m_end;
+}
+
+void BufferedFileReadStream::setPtr(const char* p) {
+    assert(p >= m_iterator && p <= m_end);
+    m_iterator = p;
+}
+
+}
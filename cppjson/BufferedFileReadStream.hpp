@@ -0,0 +1,47 @@
+#ifndef CPPJSON_BUFFEREDFILEREADSTREAM_HPP
+#define CPPJSON_BUFFEREDFILEREADSTREAM_HPP
+
+#include "Nocopyable.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+namespace cppjson {
+
+//
+// 文件输入流(定长缓冲区): only a window of the file is in memory, refilled as Reader consumes it.
+// Unlike FileReadStream the memory doesn't grow with the file, and parsing starts with the first block.
+// The buffer grows only when a token that is scanned as a whole is longer than it: a number, and a string
+// stepped over by Reader::skipValue() or Reader::scanStringToken() (as PathFilter does).
+//
+class BufferedFileReadStream : public Nocopyable {
+public:
+    typedef uint64_t Iterator;//在文件中的偏移
+    enum { kDefaultBufferSize = 64 * 1024 };
+private:
+    FILE* m_input;
+    std::vector<char> m_buffer;
+    const char* m_iterator;
+    const char* m_end;
+    uint64_t m_offset;//m_buffer[0]在文件中的偏移
+    bool m_eof;
+
+public:
+    explicit BufferedFileReadStream(FILE* input, size_t bufferSize = kDefaultBufferSize);
+    bool hasNext();//判断是否有下一个字符
+    char next();//返回当前字符,并且itretor++
+    char peek();//返回当前字符
+    Iterator getIter();
+    size_t tell();//已读取的字节数
+    void assertNext(char ch);
+
+    // 连续内存(窗口): Reader scans [getPtr(), getEnd()) in bulk and calls refill() at its end
+    const char* getPtr();//当前读位置
+    const char* getEnd();
+    void setPtr(const char* p);//移动读位置, p必须在[getPtr(), getEnd()]之间
+    bool refill();//保留[getPtr(), getEnd()), 读入更多数据, 文件结束时返回false
+};
+
+}
+
+#endif
@@ -1,39 +1,88 @@
 #include "Document.hpp"
 #include "StringReadStream.hpp"
+#include "MemoryReadStream.hpp"
+#include <cstring>
+#include <limits>
 
 namespace cppjson {
+void Document::reset() {
+    setNull();//先析构旧的节点, 再释放它们的内存
+    m_stack.clear();
+    m_frames.clear();
+    if (m_pool->isShared()) {
+        MemoryPool* pool = new MemoryPool(m_pool->getChunkSize());
+        m_pool->release();
+        m_pool = pool;
+    } else {
+        m_pool->clear();
+    }
+}
+
+// 对象中的值前面必须有键
+void Document::checkKey() {
+    if (!m_frames.empty() && m_frames.back().m_object && ((m_stack.size() - m_frames.back().m_begin) & 1) == 0) {
+        throw Exception(PARSE_MISS_KEY);
+    }
+}
+
 void Document::addValue(Value&& value) {
-    if (m_stack.empty()) {
+    if (m_frames.empty()) {
         assert(m_type == TYPE_NULL);
         //移动
-        m_type = value.m_type;
-        m_i64 = value.m_i64;
-        value.m_type = TYPE_NULL;
-        value.m_i64 = 0;
-            
-        if (m_type == TYPE_ARRAY || m_type == TYPE_OBJECT) {
-            m_stack.push_back(this);
-        }
+        moveHelper(std::move(value));
         return;
     }
+    checkKey();
+    m_stack.push_back(std::move(value));
+}
 
-    auto tmpPtr = m_stack.back();
-    if (tmpPtr->m_type == TYPE_ARRAY) {
-        tmpPtr->m_a->push_back(value);
-        if (value.m_type == TYPE_ARRAY || value.m_type == TYPE_OBJECT) {
-            m_stack.push_back(&tmpPtr->m_a->back());
-        }
-    } else if (tmpPtr->m_type == TYPE_OBJECT) {
-        if (m_key.m_type != TYPE_STRING) {
-            throw Exception(PARSE_MISS_KEY);
+const char* Document::copyText(const char* s, size_t len) {
+    char* p = static_cast<char*>(m_pool->allocate(len, 1));
+    memcpy(p, s, len);
+    return p;
+}
+
+// 短字符串放在Value里(也不借用输入), copy: the longer ones go into the pool
+Document::StackValue Document::newString(const char* s, size_t len, bool copy) {
+    if (len <= kShortCapacity) {
+        return Value(s, len, true);
+    }
+    if (!copy || len > std::numeric_limits<uint32_t>::max()) {
+        return Value(s, len, copy);
+    }
+    StackValue value(Value(copyText(s, len), len, false));
+    value.m_flags |= kPoolFlag;
+    return value;
+}
+
+void Document::setKeyPool(std::shared_ptr<KeyPool> keys) {
+    for (const char* key : m_keyCache) {
+        if (key) {
+            KeyPool::release(key);
         }
-        tmpPtr->m_o->push_back(Member(m_key, value));
-        m_key.~Value();
-        if (value.m_type == TYPE_ARRAY || value.m_type == TYPE_OBJECT) {
-            m_stack.push_back(&tmpPtr->m_o->back().m_value);
+    }
+    m_keys = std::move(keys);
+    m_keyCache.assign(m_keys ? kKeyCacheSize : 0, nullptr);
+}
+
+// 驻留的键引用KeyPool里的文本, 短的还是放在Value里
+Document::StackValue Document::newKey(const char* s, size_t len) {
+    if (len <= kShortCapacity) {
+        return Value(s, len, true);
+    }
+    uint32_t hash = hashKey(s, len);
+    const char*& cached = m_keyCache[hash & (kKeyCacheSize - 1)];
+    if (cached == nullptr || KeyPool::hashOf(cached) != hash || KeyPool::lengthOf(cached) != len || memcmp(cached, s, len) != 0) {
+        const char* interned = m_keys->intern(s, len, hash);
+        if (cached) {
+            KeyPool::release(cached);
         }
+        cached = interned;
     }
-    return;
+    KeyPool::retain(cached);
+    StackValue key(Value(cached, len, false));
+    key.m_flags = kInternFlag;
+    return key;
 }
 
 bool Document::Null() {
@@ -61,42 +110,125 @@ bool Document::Double(double d) {
     return true;
 }
 
-bool Document::String(std::string s) {
-    addValue(Value(s));
+bool Document::String(const char* s, size_t len, bool copy) {
+    addValue(newString(s, len, copy));
+    return true;
+}
+
+// a longer number goes into the pool even when the input could be borrowed: its converted value is cached in front of it
+bool Document::RawNumber(const char* s, size_t len, bool copy) {
+    Value value;
+    if (len > kRawShortCapacity && len <= std::numeric_limits<uint32_t>::max()) {
+        char* text = static_cast<char*>(m_pool->allocate(sizeof(uint64_t) + len, alignof(uint64_t))) + sizeof(uint64_t);
+        memcpy(text, s, len);
+        value.setRawNumber(text, len, false);
+        value.m_flags |= kPoolFlag;
+    } else {
+        value.setRawNumber(s, len, copy);
+    }
+    addValue(std::move(value));
     return true;
 }
 
+// 刚好size个元素的块, the pool in front of it for the copies that share it
+void* Document::poolBlock(size_t size, size_t elementSize, size_t header) {
+    if (size > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("cppjson: too many elements");
+    }
+    static_assert(sizeof(MemoryPool*) == sizeof(size_t), "the header is made of size_t slots");
+    size_t bytes = sizeof(MemoryPool*) + header + size * elementSize;
+    MemoryPool** block = static_cast<MemoryPool**>(m_pool->allocate(bytes, alignof(Value)));
+    *block = m_pool;
+    return initBlock(block + 1, size, header);
+}
+
+void Document::setPoolArray(size_t size) {
+    setArray();
+    if (size > 0) {
+        m_a = static_cast<Value*>(poolBlock(size, sizeof(Value), headerSize(static_cast<Value*>(nullptr))));
+        for (size_t i = 0; i < size; i++) {
+            new (m_a + i) Value();
+        }
+        m_length = static_cast<uint32_t>(size);
+        m_flags = kPoolFlag;
+    }
+}
+
 bool Document::StartArray() {
-    addValue(Value(TYPE_ARRAY));
+    checkKey();
+    m_frames.push_back(Frame{m_stack.size(), false});
     return true;
 }
 
 bool Document::EndArray() {
-    assert(!m_stack.empty());
-    assert(m_stack.back()->m_type == TYPE_ARRAY);
-    m_stack.pop_back();
+    assert(!m_frames.empty());
+    assert(!m_frames.back().m_object);
+    auto begin = m_stack.begin() + m_frames.back().m_begin;
+    m_frames.pop_back();
+
+    Value array(TYPE_ARRAY);
+    size_t size = m_stack.end() - begin;
+    if (size > 0) {
+        array.m_flags = kPoolFlag;
+        array.m_a = static_cast<Value*>(poolBlock(size, sizeof(Value), headerSize(static_cast<Value*>(nullptr))));
+        for (size_t i = 0; i < size; i++) {
+            moveInPool(*new (array.m_a + i) Value(), begin[i]);
+        }
+        array.m_length = static_cast<uint32_t>(size);
+    }
+    m_stack.erase(begin, m_stack.end());
+    addValue(std::move(array));
     return true;
 }
 
-bool Document::Key(std::string s) {
-    m_key = std::move(Value(s));
+bool Document::Key(const char* s, size_t len, bool copy) {
+    assert(!m_frames.empty() && m_frames.back().m_object);
+    assert(((m_stack.size() - m_frames.back().m_begin) & 1) == 0);
+    m_stack.push_back(m_keys ? newKey(s, len) : newString(s, len, copy));
     return true;
 }
 
 bool Document::StartObject() {
-    addValue(Value(TYPE_OBJECT));
+    checkKey();
+    m_frames.push_back(Frame{m_stack.size(), true});
     return true;
 }
 
 bool Document::EndObject() {
-    assert(!m_stack.empty());
-    assert(m_stack.back()->m_type == TYPE_OBJECT);
-    m_stack.pop_back();
+    assert(!m_frames.empty());
+    assert(m_frames.back().m_object);
+    auto begin = m_stack.begin() + m_frames.back().m_begin;
+    m_frames.pop_back();
+    if (((m_stack.end() - begin) & 1) != 0) {
+        throw Exception(PARSE_MISS_KEY);//最后一个键没有值
+    }
+
+    Value object(TYPE_OBJECT);
+    size_t size = (m_stack.end() - begin) / 2;
+    if (size > 0) {
+        object.m_flags = kPoolFlag;
+        object.m_o = static_cast<Member*>(poolBlock(size, sizeof(Member), headerSize(static_cast<Member*>(nullptr))));
+        for (size_t i = 0; i < size; i++) {
+            Member* member = new (object.m_o + i) Member(Value(), Value());
+            moveInPool(member->m_key, begin[2 * i]);
+            moveInPool(member->m_value, begin[2 * i + 1]);
+        }
+        object.m_length = static_cast<uint32_t>(size);
+        object.rebuildIndex(m_pool);//键的哈希只在这里算一次
+    }
+    m_stack.erase(begin, m_stack.end());
+    addValue(std::move(object));
     return true;
 }
 
 ParseError Document::parse(const char* json, size_t len) {
-    return parse(std::string(json, len));
+    MemoryReadStream is(json, len);//不拷贝输入
+    return parseStream(is);
+}
+
+ParseError Document::parse(const char* json, size_t len, ParseResult& result) {
+    MemoryReadStream is(json, len);
+    return parseStream(is, result);
 }
 
 ParseError Document::parse(std::string json) {
@@ -104,4 +236,14 @@ ParseError Document::parse(std::string json) {
     return parseStream(is);
 }
 
+ParseError Document::parseInsitu(char* json) {
+    InsituStringStream is(json);
+    return parseStream(is);
+}
+
+ParseError Document::parseInsitu(char* json, size_t len) {
+    InsituStringStream is(json, len);
+    return parseStream(is);
+}
+
 }
\ No newline at end of file
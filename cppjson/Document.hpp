@@ -2,38 +2,132 @@
 #define CPPJSON_DOCUMENT_HPP
 
 #include <cassert>
+#include <memory>
 #include <string>
+#include "KeyPool.hpp"
+#include "MemoryPool.hpp"
 #include "Reader.hpp"
 
 namespace cppjson {
 
+//
+// The element blocks and copied strings of a parsed document are allocated from the document's MemoryPool,
+// every array and object exactly sized (its elements are gathered on a stack until it ends).
+// Parsing again or destroying the document releases the pool as a whole.
+// A Value copied or moved out of the document shares its blocks with a reference to the pool (its pooled strings
+// are copied to the heap), so it outlives the document and its next parse: the pool is freed with the last of them,
+// the document parses into a new one meanwhile. Copying a document copies its value the same way.
+//
 class Document: public Value {
+    friend class ParallelArrayReader;
 public:
+    explicit Document(size_t chunkSize = MemoryPool::kDefaultChunkSize) : m_pool(new MemoryPool(chunkSize)) {}
+    ~Document() {
+        setNull();//在m_pool之前
+        setKeyPool(nullptr);
+        m_pool->release();
+    }
+
+    // 共享: the copy refers to the blocks of rhs and its pool, it parses into a pool of its own; it shares the KeyPool
+    Document(const Document& rhs) : Value(rhs), m_pool(new MemoryPool(rhs.m_pool->getChunkSize())) {
+        setKeyPool(rhs.m_keys);
+    }
+
+    Document& operator=(const Document& rhs) {
+        if (this != &rhs) {
+            Value copy(rhs);//rhs may be in this document
+            reset();
+            moveHelper(std::move(copy));
+            setKeyPool(rhs.m_keys);
+        }
+        return *this;
+    }
+
     ParseError parse(const char* json, size_t len);
     ParseError parse(std::string json);
+    ParseError parse(const char* json, size_t len, ParseResult& result);//result: 出错的位置
 
-    template <typename ReadStream>
+    // 原地解析: json is decoded in place and the strings of the document (but the short ones) point into it,
+    // so the buffer must outlive the document
+    ParseError parseInsitu(char* json);
+    ParseError parseInsitu(char* json, size_t len);
+
+    // a document can be parsed into again, the new value replaces the old one
+    // parseFlags: the grammar, see ParseFlag
+    template <unsigned parseFlags = kParseDefault, typename ReadStream>
     ParseError parseStream(ReadStream& is) {
-        return Reader::parse(is, *this);
+        reset();
+        return Reader::parse<parseFlags>(is, *this);
+    }
+
+    template <unsigned parseFlags = kParseDefault, typename ReadStream>
+    ParseError parseStream(ReadStream& is, ParseResult& result) {
+        reset();
+        return Reader::parse<parseFlags>(is, *this, result);
     }
+
+    // keys longer than kShortCapacity are interned in keys (nullptr: copied into the document like strings);
+    // set it before parsing, the documents sharing it may parse on different threads.
+    // The keys stay interned in the values and their copies, also once the document is parsed again or gone
+    void setKeyPool(std::shared_ptr<KeyPool> keys);
+    const std::shared_ptr<KeyPool>& getKeyPool() const { return m_keys; }
+
+    MemoryPool& getPool() { return *m_pool; }
+    size_t getReservedBytes() const { return m_pool->getReserved(); }
+    size_t getUsedBytes() const { return m_pool->getUsed(); }
 public:
     bool Null();
     bool Bool(bool b);
     bool Int32(int32_t i32);
     bool Int64(int64_t i64);
     bool Double(double d);
-    bool String(std::string s);
+    bool String(const char* s, size_t len, bool copy);
+    bool RawNumber(const char* s, size_t len, bool copy);//kParseRawNumbers
     bool StartArray();
     bool EndArray();
-    bool Key(std::string s);
+    bool Key(const char* s, size_t len, bool copy);
     bool StartObject();
     bool EndObject();
 private:
+    // 解析栈上的值: moved with moveHelper(), so what is in the pool stays there
+    struct StackValue : Value {
+        StackValue(Value&& value) noexcept { moveHelper(std::move(value)); }
+        StackValue(StackValue&& rhs) noexcept { moveHelper(std::move(rhs)); }
+        StackValue& operator=(StackValue&& rhs) noexcept {
+            setNull();
+            moveHelper(std::move(rhs));
+            return *this;
+        }
+    };
+
+    struct Frame {
+        size_t m_begin;//第一个元素(或键)在m_stack中的下标
+        bool m_object;
+    };
+
+    enum { kKeyCacheSize = 256 };
+
+    void reset();//m_pool still shared by copies: parse into a new one
+    void checkKey();
     void addValue(Value&& value);
+    StackValue newString(const char* s, size_t len, bool copy);
+    StackValue newKey(const char* s, size_t len);
+    void setPoolArray(size_t size);//size个null, 块在m_pool里
+    const char* copyText(const char* s, size_t len);
+    void* poolBlock(size_t size, size_t elementSize, size_t header);
+
+    // 留在MemoryPool里的移动: to is in a block of the pool that from is in (or of one that adopts it)
+    static void moveInPool(Value& to, Value& from) {
+        to.setNull();
+        to.moveHelper(std::move(from));
+    }
 
 private:
-    std::vector<Value*> m_stack;
-    Value m_key;
+    MemoryPool* m_pool;//先构造, 后析构; the document holds a reference, copies sharing its blocks others
+    std::vector<StackValue> m_stack;//未结束的数组和对象的元素, 对象是键值交替
+    std::vector<Frame> m_frames;
+    std::shared_ptr<KeyPool> m_keys;
+    std::vector<const char*> m_keyCache;//m_keys里最近的键(各持一个引用), 按哈希直接映射, so most keys are found without its lock
 };
 
 }
@@ -2,6 +2,7 @@
 #define CPPJSON_EXCEPTION_HPP
 
 #include <exception>
+#include <cstddef>
 
 namespace cppjson {
 
@@ -20,7 +21,10 @@ namespace cppjson {
     XX(MISS_KEY, "miss key") \
     XX(MISS_COLON, "miss colon") \
     XX(MISS_COMMA_OR_CURLY_BRACKET, "miss comma or curly bracket") \
-    XX(USER_STOPPED, "user stopped parse")
+    XX(USER_STOPPED, "user stopped parse") \
+    XX(DOCUMENT_TOO_LARGE, "document too large") \
+    XX(DEPTH_EXCEEDED, "nesting too deep") \
+    XX(BAD_UTF8, "invalid utf-8")
 
 enum ParseError {
 #define GEN_ERRNO(e, s) PARSE_##e,
@@ -28,6 +32,14 @@ enum ParseError {
 #undef GEN_ERRNO
 };
 
+// where a parse failed, filled by Reader::parse(is, handler, result)
+struct ParseResult {
+    ParseError m_error = PARSE_OK;
+    size_t m_offset = 0;//出错处的字节偏移, 从0开始
+    size_t m_line = 0;//从1开始, 0: 未知(输入已不在内存中)
+    size_t m_column = 0;//从1开始, 按字节计
+};
+
 class Exception : std::exception {
 public:
     explicit Exception(ParseError err):m_err(err) {}
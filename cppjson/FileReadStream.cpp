@@ -35,8 +35,31 @@ const FileReadStream::Iterator FileReadStream::getIter() {
     return m_iterator;
 }
 
+size_t FileReadStream::tell() {
+    return m_iterator - m_buffer.begin();
+}
+
 void FileReadStream::assertNext(char ch) {
-    assert(next() == ch);
+    char c = next();//NDEBUG下也要读取
+    assert(c == ch);
+    (void)c; (void)ch;
+}
+
+const char* FileReadStream::getPtr() {
+    return m_buffer.data() + (m_iterator - m_buffer.begin());
+}
+
+const char* FileReadStream::getEnd() {
+    return m_buffer.data() + m_buffer.size();
+}
+
+void FileReadStream::setPtr(const char* p) {
+    assert(p >= getPtr() && p <= getEnd());
+    m_iterator += p - getPtr();
+}
+
+const char* FileReadStream::getBegin() {
+    return m_buffer.data();
 }
 
 }
\ No newline at end of file
@@ -19,7 +19,14 @@ public:
     char next();//返回当前字符,并且itretor++
     char peek();//返回当前字符
     const Iterator getIter();
+    size_t tell();//已读取的字节数
     void assertNext(char ch);
+
+    // 连续内存: Reader uses these to scan the buffer in bulk
+    const char* getPtr();//当前读位置
+    const char* getEnd();
+    void setPtr(const char* p);//移动读位置, p必须在[getPtr(), getEnd()]之间
+    const char* getBegin();
 };
 
 }
@@ -14,4 +14,8 @@ void FileWriteStream::put(std::string str) {//放入一个string对象
     fprintf(m_output, "%.*s", static_cast<int>(str.length()), str.data());
 }
 
+void FileWriteStream::put(const char* str, size_t len) {//放入len个字符
+    fwrite(str, 1, len, m_output);
+}
+
 }
\ No newline at end of file
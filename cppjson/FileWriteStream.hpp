@@ -18,6 +18,8 @@ public:
     void put(const char* str);//放入一个字符串
 
     void put(std::string str);//放入一个string对象
+
+    void put(const char* str, size_t len);//放入len个字符
 };
 
 }
@@ -0,0 +1,40 @@
+#ifndef CPPJSON_HANDLERADAPTER_HPP
+#define CPPJSON_HANDLERADAPTER_HPP
+
+#include "Nocopyable.hpp"
+#include <cstdint>
+#include <string>
+
+namespace cppjson {
+
+//
+// 旧式Handler的适配器: Reader and the other engines call String/Key(const char*, size_t, bool copy),
+// a handler whose String/Key still take a std::string is wrapped in this, each string is then copied once for it
+//
+//     StringHandlerAdapter<MyHandler> adapter(handler);
+//     Reader::parse(is, adapter);
+//
+template <typename Handler>
+class StringHandlerAdapter : public Nocopyable {
+public:
+    explicit StringHandlerAdapter(Handler& handler) : m_handler(handler) {}
+
+    bool Null() { return m_handler.Null(); }
+    bool Bool(bool b) { return m_handler.Bool(b); }
+    bool Int32(int32_t i32) { return m_handler.Int32(i32); }
+    bool Int64(int64_t i64) { return m_handler.Int64(i64); }
+    bool Double(double d) { return m_handler.Double(d); }
+    bool String(const char* s, size_t len, bool) { return m_handler.String(std::string(s, len)); }
+    bool Key(const char* s, size_t len, bool) { return m_handler.Key(std::string(s, len)); }
+    bool StartArray() { return m_handler.StartArray(); }
+    bool EndArray() { return m_handler.EndArray(); }
+    bool StartObject() { return m_handler.StartObject(); }
+    bool EndObject() { return m_handler.EndObject(); }
+
+private:
+    Handler& m_handler;
+};
+
+}
+
+#endif
@@ -0,0 +1,279 @@
+#ifndef CPPJSON_INDEXREADER_HPP
+#define CPPJSON_INDEXREADER_HPP
+
+#include "Reader.hpp"
+#include "MemoryReadStream.hpp"
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace cppjson {
+
+//
+// 两阶段解析:
+//     stage 1: buildStructuralIndex() finds the structural characters, token starts and both quotes of every string
+//              64 bytes at a time, and inside strings the backslashes and control characters
+//     stage 2: walks the index without recursion and emits the same Handler events (and errors) as Reader::parse.
+//              Tokens are decoded where the index points: a string without indexed characters between its quotes
+//              goes to the handler as it is, numbers and literals are converted in place, nothing is scanned twice.
+// Stage 1 runs one chunk ahead of stage 2, so the chunk is still in cache when its tokens are decoded.
+// The index and the decoding buffer are kept between calls, reuse one IndexReader for a batch of documents.
+//
+class IndexReader : public Nocopyable {
+public:
+    template <typename Handler>
+    ParseError parse(const char* json, size_t len, Handler& handler, size_t maxDepth = Reader::kDefaultMaxDepth) {
+        if (len > std::numeric_limits<uint32_t>::max()) {//offsets don't fit the index
+            MemoryReadStream is(json, len);
+            return Reader::parse(is, handler, maxDepth);
+        }
+        m_json = json;
+        m_end = json + len;
+        m_indexed = 0;
+        m_state = StructuralIndexState();
+        m_index.resize(kChunkSize);
+        m_next = m_count = 0;
+        try {
+            return walk(handler, maxDepth);
+        } catch (Exception& e) {//thrown by the handler itself
+            return e.getError();
+        }
+    }
+
+private:
+#define CALL(expr) do {if (!(expr)) return PARSE_USER_STOPPED; } while(0)
+#define CHECK_PARSE(expr) do { ParseError parseError = (expr); if (parseError != PARSE_OK) return parseError; } while(0)
+
+    template <typename Handler>
+    ParseError walk(Handler& handler, size_t maxDepth) {
+        enum State { kValue, kAfterValue, kKey };
+
+        m_stack.clear();
+        State state = kValue;
+
+        while (true) {
+            const char* token = peek();
+            char ch = token != nullptr ? *token : '\0';
+            switch (state) {
+                case kValue:
+                    if (token == nullptr) {
+                        return PARSE_EXPECT_VALUE;
+                    }
+                    if ((ch == '[' || ch == '{') && m_stack.size() == maxDepth) {
+                        return PARSE_DEPTH_EXCEEDED;
+                    }
+                    if (ch == '[') {
+                        m_next++;
+                        CALL(handler.StartArray());
+                        if (nextIs(']')) {
+                            m_next++;
+                            CALL(handler.EndArray());
+                            state = kAfterValue;
+                        } else {
+                            m_stack.push_back('[');
+                        }
+                    } else if (ch == '{') {
+                        m_next++;
+                        CALL(handler.StartObject());
+                        if (nextIs('}')) {
+                            m_next++;
+                            CALL(handler.EndObject());
+                            state = kAfterValue;
+                        } else {
+                            m_stack.push_back('{');
+                            state = kKey;
+                        }
+                    } else if (ch == '"') {
+                        CHECK_PARSE(parseString(handler, false));
+                        state = kAfterValue;
+                    } else {
+                        const char* p = nullptr;
+                        m_next++;
+                        CHECK_PARSE(parseScalar(token, m_end, handler, p));
+                        // the rest of the scalar's run isn't indexed: only blanks may follow it up to the next token
+                        const char* next = peek();
+                        if (next == nullptr) {
+                            next = m_end;
+                        }
+                        if (p != next && skipWhiteSpace(p, m_end) != next) {
+                            return m_stack.empty() ? PARSE_ROOT_NOT_SINGULAR :
+                                   m_stack.back() == '[' ? PARSE_MISS_COMMA_OR_SQUARE_BRACKET :
+                                                           PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+                        }
+                        state = kAfterValue;
+                    }
+                    break;
+
+                case kAfterValue:
+                    if (m_stack.empty()) {
+                        return token == nullptr ? PARSE_OK : PARSE_ROOT_NOT_SINGULAR;
+                    }
+                    m_next++;
+                    if (m_stack.back() == '[') {
+                        if (ch == ',') {
+                            state = kValue;
+                        } else if (ch == ']') {
+                            m_stack.pop_back();
+                            CALL(handler.EndArray());
+                        } else {
+                            return PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+                        }
+                    } else {
+                        if (ch == ',') {
+                            state = kKey;
+                        } else if (ch == '}') {
+                            m_stack.pop_back();
+                            CALL(handler.EndObject());
+                        } else {
+                            return PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+                        }
+                    }
+                    break;
+
+                case kKey:
+                    if (ch != '"') {
+                        return PARSE_MISS_KEY;
+                    }
+                    CHECK_PARSE(parseString(handler, true));
+                    if (!nextIs(':')) {
+                        return PARSE_MISS_COLON;
+                    }
+                    m_next++;
+                    state = kValue;
+                    break;
+            }
+        }
+    }
+
+    // the current entry is the opening quotation mark, left after the closing one.
+    // The next entry is the closing quotation mark unless the string has escapes or control characters,
+    // those are decoded in order into m_buffer, so that the first error is the one Reader reports.
+    template <typename Handler>
+    ParseError parseString(Handler& handler, bool isKey) {
+        const char* s = m_json + m_index[m_next++] + 1;
+        const char* q = peek();
+        if (q != nullptr && *q == '"') {
+            m_next++;
+            return Reader::putString(handler, isKey, s, q - s, true);
+        }
+        m_buffer.clear();
+        const char* p = s;
+        while (true) {
+            const char* special = peek();
+            if (special == nullptr) {
+                return PARSE_MISS_QUOTATION_MARK;
+            }
+            m_buffer.append(p, special);
+            m_next++;
+            if (*special == '"') {
+                return Reader::putString(handler, isKey, m_buffer.data(), m_buffer.size(), true);
+            }
+            Cursor cursor{special + 1, m_end};
+            bool closed = false;
+            CHECK_PARSE(Reader::parseStringChar(cursor, m_buffer, *special, closed));
+            p = cursor.m_p;
+            const char* next;
+            while ((next = peek()) != nullptr && next < p) {//the '\\' of a surrogate pair's second half was read with the first
+                m_next++;
+            }
+        }
+    }
+
+    // after: set to the end of the scalar
+    template <typename Handler>
+    static ParseError parseScalar(const char* p, const char* end, Handler& handler, const char*& after) {
+        switch (*p) {
+            case 'n':
+                CHECK_PARSE(matchLiteral(p, end, "null", after));
+                CALL(handler.Null());
+                return PARSE_OK;
+            case 't':
+                CHECK_PARSE(matchLiteral(p, end, "true", after));
+                CALL(handler.Bool(true));
+                return PARSE_OK;
+            case 'f':
+                CHECK_PARSE(matchLiteral(p, end, "false", after));
+                CALL(handler.Bool(false));
+                return PARSE_OK;
+            case 'N':
+                CHECK_PARSE(matchLiteral(p, end, "NaN", after));
+                CALL(handler.Double(NAN));
+                return PARSE_OK;
+            case 'I':
+                CHECK_PARSE(matchLiteral(p, end, "Infinity", after));
+                CALL(handler.Double(INFINITY));
+                return PARSE_OK;
+            default: {
+                Reader::MemoryCursor cursor{p, end};
+                Reader::Number number;
+                CHECK_PARSE(Reader::scanNumber<kParseDefault>(cursor, number));
+                after = cursor.m_p;
+                return Reader::convertNumber(handler, number, p, cursor.m_p - p);
+            }
+        }
+    }
+
+    static ParseError matchLiteral(const char* p, const char* end, const char* literal, const char*& after) {
+        size_t len = strlen(literal);
+        if (static_cast<size_t>(end - p) < len || memcmp(p, literal, len) != 0) {
+            return PARSE_BAD_VALUE;
+        }
+        after = p + len;
+        return PARSE_OK;
+    }
+
+#undef CALL
+#undef CHECK_PARSE
+
+    // the current entry, nullptr past the last one
+    const char* peek() {
+        if (m_next == m_count && !indexChunk()) {
+            return nullptr;
+        }
+        return m_json + m_index[m_next];
+    }
+
+    bool nextIs(char ch) {
+        const char* token = peek();
+        return token != nullptr && *token == ch;
+    }
+
+    // stage 1 on the next chunk that has entries, false at the end of the input
+    bool indexChunk() {
+        size_t len = m_end - m_json;
+        while (m_indexed < len) {
+            size_t chunk = len - m_indexed < kChunkSize ? len - m_indexed : kChunkSize;
+            m_count = buildStructuralIndex(m_json, m_indexed, chunk, m_state, m_index.data());
+            m_indexed += chunk;
+            m_next = 0;
+            if (m_count != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // what follows a backslash, read like a stream: '\0' past the end
+    struct Cursor {
+        const char* m_p;
+        const char* m_end;
+        char next() { return m_p != m_end ? *m_p++ : '\0'; }
+    };
+
+private:
+    static const size_t kChunkSize = 16 * 1024;//a multiple of 64, small enough for L1/L2
+
+    const char* m_json = nullptr;
+    const char* m_end = nullptr;
+    size_t m_indexed = 0;//bytes given to stage 1
+    StructuralIndexState m_state;
+    std::vector<uint32_t> m_index;//entries of the current chunk
+    size_t m_next = 0;
+    size_t m_count = 0;
+    std::vector<char> m_stack;//'[' or '{'
+    std::string m_buffer;//解码字符串用
+};
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+#include "InsituStringStream.hpp"
+#include <cassert>
+#include <cstring>
+
+namespace cppjson {
+
+InsituStringStream::InsituStringStream(char* json) : InsituStringStream(json, strlen(json)) {}
+
+bool InsituStringStream::hasNext() {//判断是否有下一个字符
+    return m_iterator != m_end;
+}
+
+char InsituStringStream::next() {//返回当前字符,并且itretor++
+    if (hasNext()) {
+        return *m_iterator++;
+    }
+    return '\0';
+}
+
+char InsituStringStream::peek() {//返回当前字符
+    return hasNext() ? *m_iterator : '\0';
+}
+
+InsituStringStream::Iterator InsituStringStream::getIter() {
+    return m_iterator;
+}
+
+size_t InsituStringStream::tell() {
+    return m_iterator - m_start;
+}
+
+void InsituStringStream::assertNext(char ch) {
+    char c = next();//NDEBUG下也要读取
+    assert(c == ch);
+    (void)c; (void)ch;
+}
+
+const char* InsituStringStream::getPtr() {
+    return m_iterator;
+}
+
+const char* InsituStringStream::getEnd() {
+    return m_end;
+}
+
+void InsituStringStream::setPtr(const char* p) {
+    assert(p >= m_iterator && p <= m_end);
+    m_iterator += p - m_iterator;
+}
+
+char* InsituStringStream::putBegin() {
+    m_begin = m_head = m_iterator;
+    return m_begin;
+}
+
+void InsituStringStream::put(char ch) {
+    assert(m_head != nullptr && m_head < m_iterator);
+    *m_head++ = ch;
+}
+
+void InsituStringStream::put(const char* s, size_t len) {
+    assert(m_head != nullptr && m_head + len <= m_iterator);
+    if (m_head != s) {
+        memmove(m_head, s, len);
+    }
+    m_head += len;
+}
+
+size_t InsituStringStream::putEnd() {
+    size_t len = static_cast<size_t>(m_head - m_begin);
+    assert(m_head < m_iterator);
+    *m_head = '\0';//结果也是一个C字符串
+    m_head = nullptr;
+    return len;
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef CPPJSON_INSITUSTRINGSTREAM_HPP
+#define CPPJSON_INSITUSTRINGSTREAM_HPP
+
+#include "Nocopyable.hpp"
+#include <cstddef>
+
+namespace cppjson {
+
+// 原地解析流: 字符串在输入缓冲区内直接解码, 解析结果引用该缓冲区
+// the buffer is modified by the parse and must outlive everything that refers into it
+class InsituStringStream : public Nocopyable {
+public:
+    typedef char* Iterator;
+private:
+    char* m_iterator;//读指针
+    char* m_end;
+    char* m_begin;
+    char* m_head;//写指针
+    char* m_start;//输入的开始
+
+public:
+    explicit InsituStringStream(char* json);
+    InsituStringStream(char* json, size_t len) : m_iterator(json), m_end(json + len), m_begin(nullptr), m_head(nullptr), m_start(json) {}
+    bool hasNext();//判断是否有下一个字符
+    char next();//返回当前字符,并且itretor++
+    char peek();//返回当前字符
+    Iterator getIter();
+    size_t tell();//已读取的字节数
+    void assertNext(char ch);
+
+    // 连续内存: Reader uses these to scan the buffer in bulk
+    const char* getPtr();//当前读位置
+    const char* getEnd();
+    void setPtr(const char* p);//移动读位置, p必须在[getPtr(), getEnd()]之间
+
+    // in-situ write side, the write head never passes the read iterator
+    char* putBegin();//写指针从当前读位置开始
+    void put(char ch);//写入一个字符
+    void put(const char* s, size_t len);//写入len个字符, s可以与写指针重叠
+    size_t putEnd();//结束写入, 返回写入的长度
+};
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "KeyPool.hpp"
+#include "Value.hpp"
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+namespace cppjson {
+
+KeyPool::~KeyPool() {
+    for (const char* key : m_table) {
+        if (key) {
+            release(key);//Values still holding it keep it
+        }
+    }
+}
+
+const char* KeyPool::intern(const char* s, size_t len) {
+    return intern(s, len, Value::hashKey(s, len));
+}
+
+const char* KeyPool::intern(const char* s, size_t len, uint32_t hash) {
+    if (len > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("cppjson: key longer than 4 GiB");
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if ((m_size + 1) * 2 > m_table.size()) {
+        rebuild();
+    }
+    size_t mask = m_table.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        const char* key = m_table[i];
+        if (key == nullptr) {
+            static_assert(sizeof(Header) == 16 && offsetof(Header, m_refs) == 8, "Value finds the count in front of the key");
+            Header* h = static_cast<Header*>(::operator new(bytes(len)));
+            h->m_hash = hash;
+            h->m_length = static_cast<uint32_t>(len);
+            new (&h->m_refs) std::atomic<size_t>(2);//the pool and the caller
+            char* p = reinterpret_cast<char*>(h + 1);
+            memcpy(p, s, len);
+            p[len] = '\0';
+            m_table[i] = p;
+            m_size++;
+            m_bytes += bytes(len);
+            return p;
+        }
+        if (hashOf(key) == hash && lengthOf(key) == len && memcmp(key, s, len) == 0) {
+            retain(key);
+            return key;
+        }
+    }
+}
+
+void KeyPool::release(const char* key) {
+    std::atomic<size_t>& refs = header(key)->m_refs;
+    if (refs.load(std::memory_order_acquire) == 1 || refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        ::operator delete(header(key));
+    }
+}
+
+// 只有表引用的键(计数为1)没有Value在用: no Value can take it again but through intern(), which holds the lock
+void KeyPool::rebuild() {
+    std::vector<const char*> live;
+    live.reserve(m_size);
+    for (const char* key : m_table) {
+        if (key == nullptr) {
+            continue;
+        }
+        if (header(key)->m_refs.load(std::memory_order_acquire) == 1) {
+            m_bytes -= bytes(lengthOf(key));
+            ::operator delete(header(key));
+        } else {
+            live.push_back(key);
+        }
+    }
+    size_t size = 64;
+    while ((live.size() + 1) * 4 > size) {
+        size *= 2;
+    }
+    std::vector<const char*> table(size, nullptr);
+    size_t mask = size - 1;
+    for (const char* key : live) {
+        size_t i = hashOf(key) & mask;
+        while (table[i]) {
+            i = (i + 1) & mask;
+        }
+        table[i] = key;
+    }
+    m_table.swap(table);
+    m_size = live.size();
+}
+
+size_t KeyPool::purge() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t before = m_size;
+    rebuild();
+    return before - m_size;
+}
+
+size_t KeyPool::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+}
+
+size_t KeyPool::getReservedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes + m_table.capacity() * sizeof(const char*);
+}
+
+}
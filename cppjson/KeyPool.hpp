@@ -0,0 +1,66 @@
+#ifndef CPPJSON_KEYPOOL_HPP
+#define CPPJSON_KEYPOOL_HPP
+
+#include "Nocopyable.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace cppjson {
+
+//
+// 键的驻留表: one immutable, reference counted copy of every distinct key, with its hash stored in front of it.
+// Shared by Documents through a std::shared_ptr (see Document::setKeyPool), from any number of threads;
+// the keys of records parsed with it are then stored once, the hash index of an object reads their hashes
+// instead of computing them, and two keys from the same pool are equal exactly when their pointers are.
+// The pool and every Value holding a key (copies too) own a reference: a key no Value uses any more is freed
+// when the table would grow or on purge(), a key outlives the pool while Values use it.
+//
+class KeyPool : public Nocopyable {
+public:
+    KeyPool() = default;
+    ~KeyPool();
+
+    // the pooled copy of s, '\0' terminated, with a reference for the caller (see release()); hash: Value::hashKey(s, len)
+    const char* intern(const char* s, size_t len);
+    const char* intern(const char* s, size_t len, uint32_t hash);
+
+    // key: returned by intern()
+    static uint32_t hashOf(const char* key) { return header(key)->m_hash; }
+    static size_t lengthOf(const char* key) { return header(key)->m_length; }
+
+    static void retain(const char* key) { header(key)->m_refs.fetch_add(1, std::memory_order_relaxed); }
+    static void release(const char* key);//最后一个引用时释放
+
+    size_t purge();//释放没有Value使用的键, 返回个数
+    size_t size() const;//不同的键的个数
+    size_t getReservedBytes() const;
+
+private:
+    // [Header][key]['\0'], the reference count right in front of the key like that of a heap string of Value
+    struct Header {
+        uint32_t m_hash;
+        uint32_t m_length;
+        std::atomic<size_t> m_refs;//the pool's one and the Values'
+    };
+
+    static Header* header(const char* key) {
+        return reinterpret_cast<Header*>(const_cast<char*>(key)) - 1;
+    }
+
+    static size_t bytes(size_t len) { return sizeof(Header) + len + 1; }
+
+    void rebuild();//扔掉没人用的键, then resize the table to a quarter full at most
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<const char*> m_table;//开放寻址, 负载不超过一半
+    size_t m_size = 0;
+    size_t m_bytes = 0;//键占用的字节
+};
+
+}
+
+#endif
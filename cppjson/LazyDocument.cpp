@@ -0,0 +1,270 @@
+#include "LazyDocument.hpp"
+#include <cstring>
+
+namespace cppjson {
+
+namespace {
+
+// 接收一个标量
+struct ScalarCapture {
+    ValueType m_type = TYPE_NULL;
+    bool m_b = false;
+    int32_t m_i32 = 0;
+    int64_t m_i64 = 0;
+    double m_d = 0;
+    std::string m_s;
+
+    bool Null() { m_type = TYPE_NULL; return true; }
+    bool Bool(bool b) { m_type = TYPE_BOOL; m_b = b; return true; }
+    bool Int32(int32_t i32) { m_type = TYPE_INT32; m_i32 = i32; m_i64 = i32; return true; }
+    bool Int64(int64_t i64) { m_type = TYPE_INT64; m_i64 = i64; return true; }
+    bool Double(double d) { m_type = TYPE_DOUBLE; m_d = d; return true; }
+    bool String(const char* s, size_t len, bool) { m_type = TYPE_STRING; m_s.assign(s, len); return true; }
+    bool Key(const char* s, size_t len, bool copy) { return String(s, len, copy); }
+    bool StartArray() { return false; }
+    bool EndArray() { return false; }
+    bool StartObject() { return false; }
+    bool EndObject() { return false; }
+};
+
+}
+
+template <typename Handler>
+void LazyValue::decodeScalar(Handler& handler) const {
+    MemoryReadStream is(m_p, m_end - m_p);
+    Reader::check(Reader::parseScalar(is, handler));
+    //"12ab"这样的值: the scalar must run up to a delimiter
+    if (is.getPtr() != m_end && !Reader::isDelimiter(*is.getPtr())) {
+        throw Exception(PARSE_BAD_VALUE);
+    }
+}
+
+ParseError LazyDocument::parse(const char* json, size_t len) {
+    const char* end = json + len;
+    const char* p = skipWhiteSpace(json, end);
+    if (p == end) {
+        m_root = LazyValue();
+        return PARSE_EXPECT_VALUE;
+    }
+    m_root = LazyValue(p, end);
+    return PARSE_OK;
+}
+
+ParseError LazyDocument::parse(const std::string& json) {
+    return parse(json.data(), json.size());
+}
+
+ValueType LazyValue::getType() const {
+    switch (*m_p) {
+        case 'n': return TYPE_NULL;
+        case 't':
+        case 'f': return TYPE_BOOL;
+        case '"': return TYPE_STRING;
+        case '[': return TYPE_ARRAY;
+        case '{': return TYPE_OBJECT;
+    }
+    ScalarCapture capture;
+    decodeScalar(capture);
+    return capture.m_type;
+}
+
+size_t LazyValue::getSize() const {
+    size_t count = 0;
+    if (isArray()) {
+        LazyArray array = getArray();
+        for (auto it = array.begin(); it != array.end(); ++it) {
+            count++;
+        }
+    } else {
+        LazyObject object = getObject();
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool LazyValue::getBool() const {
+    ScalarCapture capture;
+    decodeScalar(capture);
+    assert(capture.m_type == TYPE_BOOL);
+    return capture.m_b;
+}
+
+int32_t LazyValue::getInt32() const {
+    ScalarCapture capture;
+    decodeScalar(capture);
+    assert(capture.m_type == TYPE_INT32);
+    return capture.m_i32;
+}
+
+int64_t LazyValue::getInt64() const {
+    ScalarCapture capture;
+    decodeScalar(capture);
+    assert(capture.m_type == TYPE_INT64 || capture.m_type == TYPE_INT32);
+    return capture.m_i64;
+}
+
+double LazyValue::getDouble() const {
+    ScalarCapture capture;
+    decodeScalar(capture);
+    assert(capture.m_type == TYPE_DOUBLE);
+    return capture.m_d;
+}
+
+std::string LazyValue::getString() const {
+    assert(isString());
+    ScalarCapture capture;
+    decodeScalar(capture);
+    return std::move(capture.m_s);
+}
+
+LazyArray LazyValue::getArray() const {
+    assert(isArray());
+    return LazyArray(LazyArrayIterator(m_p + 1, m_end), LazyArrayIterator());
+}
+
+LazyObject LazyValue::getObject() const {
+    assert(isObject());
+    return LazyObject(LazyMemberIterator(m_p + 1, m_end, true), LazyMemberIterator());
+}
+
+LazyValue LazyValue::operator[] (StringRef key) const {
+    LazyMemberIterator it = findMember(key);
+    assert(it != getObject().end());
+    return it->m_value;
+}
+
+LazyValue LazyValue::operator[] (size_t i) const {
+    LazyArray array = getArray();
+    LazyArrayIterator it = array.begin();
+    for (; i > 0 && it != array.end(); i--) {
+        ++it;
+    }
+    assert(it != array.end());
+    return *it;
+}
+
+LazyMemberIterator LazyValue::findMember(StringRef key) const {
+    return findMember(key.data(), key.size());
+}
+
+LazyMemberIterator LazyValue::findMember(const char* key, size_t len) const {
+    assert(isObject());
+    // 从m_hint找到结尾, 再从头找到m_hint
+    const char* stop = m_hint;
+    LazyMemberIterator it = stop ? LazyMemberIterator(stop, m_end, false) : LazyMemberIterator(m_p + 1, m_end, true);
+    LazyMemberIterator end;
+    bool wrapped = stop == nullptr;
+    while (true) {
+        if (it == end) {
+            if (wrapped) {
+                return end;
+            }
+            wrapped = true;
+            it = LazyMemberIterator(m_p + 1, m_end, true);
+            continue;
+        }
+        if (wrapped && it->m_key.m_p == stop) {
+            return end;
+        }
+        const char* raw = it->m_key.m_p + 1;
+        const char* rawEnd = Reader::skipString(raw, m_end) - 1;//构造迭代器时已检查过
+        bool match;
+        if (memchr(raw, '\\', rawEnd - raw) == nullptr) {//没有转义, 直接比较原文
+            match = static_cast<size_t>(rawEnd - raw) == len && memcmp(raw, key, len) == 0;
+        } else {
+            std::string decoded = it->m_key.getString();
+            match = decoded.size() == len && memcmp(decoded.data(), key, len) == 0;
+        }
+        if (match) {
+            LazyMemberIterator next = it;
+            ++next;
+            m_hint = next == end ? nullptr : next->m_key.m_p;
+            return it;
+        }
+        ++it;
+    }
+}
+
+const char* LazyValue::skip() const {
+    MemoryReadStream is(m_p, m_end - m_p);
+    Reader::skipValue(is);
+    return is.getPtr();
+}
+
+size_t LazyValue::getRawLength() const {
+    return skip() - m_p;
+}
+
+LazyArrayIterator::LazyArrayIterator(const char* p, const char* end) {
+    p = skipWhiteSpace(p, end);
+    if (p == end) {
+        throw Exception(PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+    }
+    if (*p != ']') {
+        m_value = LazyValue(p, end);
+    }
+}
+
+LazyArrayIterator& LazyArrayIterator::operator++() {
+    const char* end = m_value.m_end;
+    const char* p = skipWhiteSpace(m_value.skip(), end);
+    if (p == end) {
+        throw Exception(PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+    }
+    if (*p == ']') {
+        m_value = LazyValue();
+    } else if (*p == ',') {
+        p = skipWhiteSpace(p + 1, end);
+        if (p == end) {
+            throw Exception(PARSE_EXPECT_VALUE);
+        }
+        m_value = LazyValue(p, end);
+    } else {
+        throw Exception(PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+    }
+    return *this;
+}
+
+LazyMemberIterator::LazyMemberIterator(const char* p, const char* end, bool first) {
+    p = skipWhiteSpace(p, end);
+    if (first && p != end && *p == '}') {
+        return;
+    }
+    if (p == end || *p != '"') {
+        throw Exception(PARSE_MISS_KEY);
+    }
+    m_member.m_key = LazyValue(p, end);
+    p = Reader::skipString(p + 1, end);
+    if (p == nullptr) {
+        throw Exception(PARSE_MISS_QUOTATION_MARK);
+    }
+    p = skipWhiteSpace(p, end);
+    if (p == end || *p != ':') {
+        throw Exception(PARSE_MISS_COLON);
+    }
+    p = skipWhiteSpace(p + 1, end);
+    if (p == end) {
+        throw Exception(PARSE_EXPECT_VALUE);
+    }
+    m_member.m_value = LazyValue(p, end);
+}
+
+LazyMemberIterator& LazyMemberIterator::operator++() {
+    const char* end = m_member.m_value.m_end;
+    const char* p = skipWhiteSpace(m_member.m_value.skip(), end);
+    if (p == end) {
+        throw Exception(PARSE_MISS_COMMA_OR_CURLY_BRACKET);
+    }
+    if (*p == '}') {
+        m_member = LazyMember();
+    } else if (*p == ',') {
+        *this = LazyMemberIterator(p + 1, end, false);
+    } else {
+        throw Exception(PARSE_MISS_COMMA_OR_CURLY_BRACKET);
+    }
+    return *this;
+}
+
+}
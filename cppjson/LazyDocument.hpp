@@ -0,0 +1,164 @@
+#ifndef CPPJSON_LAZYDOCUMENT_HPP
+#define CPPJSON_LAZYDOCUMENT_HPP
+
+#include <cassert>
+#include <string>
+#include "Reader.hpp"
+#include "StringRef.hpp"
+#include "MemoryReadStream.hpp"
+
+namespace cppjson {
+
+class LazyDocument;
+class LazyArrayIterator;
+class LazyMemberIterator;
+class LazyArray;
+class LazyObject;
+
+//
+// LazyValue: 按需解析, a value is just its position in the text.
+// Accessors decode only what they are asked for: the members and elements walked over on the way
+// are skipped by Reader::skipValue(), without unescaping strings or converting numbers.
+// Malformed JSON is found on access, the accessors then throw cppjson::Exception.
+//
+class LazyValue {
+    friend class LazyDocument;
+    friend class LazyArrayIterator;
+    friend class LazyMemberIterator;
+public:
+    LazyValue() : m_p(nullptr), m_end(nullptr), m_hint(nullptr) {}
+
+    ValueType getType() const;//数字要转换一次才知道是INT32, INT64还是DOUBLE
+    size_t getSize() const;//元素(成员)个数, 要走一遍容器
+
+    bool isNull() const{ return getType() == TYPE_NULL; }
+    bool isBool() const{ return getType() == TYPE_BOOL; }
+    bool isInt32() const{ return getType() == TYPE_INT32; }
+    bool isInt64() const{ return getType() == TYPE_INT64 || getType() == TYPE_INT32; }
+    bool isDouble() const{ return getType() == TYPE_DOUBLE; }
+    bool isString() const{ return *m_p == '"'; }
+    bool isArray()  const{ return *m_p == '['; }
+    bool isObject() const{ return *m_p == '{'; }
+
+    bool getBool() const;
+    int32_t getInt32() const;
+    int64_t getInt64() const;
+    double getDouble() const;
+    std::string getString() const;
+
+    LazyArray getArray() const;
+    LazyObject getObject() const;
+
+    // 成员查找从上一次找到的成员之后开始, so fields read in document order are found in one pass
+    LazyValue operator[] (StringRef key) const;
+    LazyValue operator[] (size_t i) const;
+
+    LazyMemberIterator findMember(const char* key, size_t len) const;
+    LazyMemberIterator findMember(StringRef key) const;
+
+    // the text of the value, e.g. to forward it unchanged
+    const char* getRaw() const { return m_p; }
+    size_t getRawLength() const;
+
+    // 物化: parses the value, containers included, into handler (e.g. a Document)
+    template <typename Handler>
+    ParseError accept(Handler& handler) const {
+        MemoryReadStream is(m_p, m_end - m_p);
+        try {
+            Reader::check(Reader::parseValue(is, handler, Reader::kDefaultMaxDepth));
+            return PARSE_OK;
+        } catch (Exception& e) {
+            return e.getError();
+        }
+    }
+
+private:
+    LazyValue(const char* p, const char* end) : m_p(p), m_end(end), m_hint(nullptr) {}
+
+    const char* skip() const;//返回值之后的位置
+    template <typename Handler>
+    void decodeScalar(Handler& handler) const;
+
+    const char* m_p;//值的第一个字符
+    const char* m_end;//文本的结尾
+    mutable const char* m_hint;//对象: 下一次查找开始的成员
+};
+
+struct LazyMember {
+    LazyValue m_key;
+    LazyValue m_value;
+};
+
+// forward iterators, the end iterator is the one whose position is null
+class LazyArrayIterator {
+    friend class LazyValue;
+public:
+    const LazyValue& operator*() const { return m_value; }
+    const LazyValue* operator->() const { return &m_value; }
+    LazyArrayIterator& operator++();
+    bool operator==(const LazyArrayIterator& rhs) const { return m_value.m_p == rhs.m_value.m_p; }
+    bool operator!=(const LazyArrayIterator& rhs) const { return m_value.m_p != rhs.m_value.m_p; }
+
+private:
+    LazyArrayIterator() {}
+    LazyArrayIterator(const char* p, const char* end);//p: after '[' or ','
+
+    LazyValue m_value;
+};
+
+class LazyMemberIterator {
+    friend class LazyValue;
+public:
+    const LazyMember& operator*() const { return m_member; }
+    const LazyMember* operator->() const { return &m_member; }
+    LazyMemberIterator& operator++();
+    bool operator==(const LazyMemberIterator& rhs) const { return m_member.m_key.m_p == rhs.m_member.m_key.m_p; }
+    bool operator!=(const LazyMemberIterator& rhs) const { return m_member.m_key.m_p != rhs.m_member.m_key.m_p; }
+
+private:
+    LazyMemberIterator() {}
+    LazyMemberIterator(const char* p, const char* end, bool first);//p: after '{' or ','
+
+    LazyMember m_member;
+};
+
+class LazyArray {
+public:
+    LazyArray(LazyArrayIterator begin, LazyArrayIterator end) : m_begin(begin), m_end(end) {}
+    LazyArrayIterator begin() const { return m_begin; }
+    LazyArrayIterator end() const { return m_end; }
+private:
+    LazyArrayIterator m_begin, m_end;
+};
+
+class LazyObject {
+public:
+    LazyObject(LazyMemberIterator begin, LazyMemberIterator end) : m_begin(begin), m_end(end) {}
+    LazyMemberIterator begin() const { return m_begin; }
+    LazyMemberIterator end() const { return m_end; }
+private:
+    LazyMemberIterator m_begin, m_end;
+};
+
+//
+// LazyDocument: parse() only finds the root value, the text is decoded as it is accessed.
+// The json buffer is not copied and must outlive the document and its LazyValues.
+//
+class LazyDocument : public Nocopyable {
+public:
+    ParseError parse(const char* json, size_t len);
+    ParseError parse(const std::string& json);
+    ParseError parse(std::string&& json) = delete;//临时字符串在解析后就析构了
+
+    LazyValue root() const {
+        assert(m_root.m_p != nullptr);
+        return m_root;
+    }
+
+private:
+    LazyValue m_root;
+};
+
+}
+
+#endif
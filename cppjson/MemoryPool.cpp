@@ -0,0 +1,119 @@
+#include "MemoryPool.hpp"
+
+namespace cppjson {
+
+MemoryPool::MemoryPool(size_t chunkSize) : m_chunkSize(chunkSize < 256 ? 256 : chunkSize) {}
+
+MemoryPool::~MemoryPool() {
+    releaseAdopted();
+    while (m_head) {
+        Chunk* next = m_head->m_next;
+        ::operator delete(m_head);
+        m_head = next;
+    }
+}
+
+MemoryPool::Chunk* MemoryPool::newChunk(size_t size, Chunk* next) {
+    Chunk* chunk = static_cast<Chunk*>(::operator new(kHeaderSize + size));
+    chunk->m_next = next;
+    chunk->m_size = size;
+    return chunk;
+}
+
+void* MemoryPool::allocateSlow(size_t size, size_t align) {
+    if (size + align > m_chunkSize / 2) {
+        // 大块单独一个chunk, 当前chunk的剩余空间留给后面的小块
+        Chunk* chunk = newChunk(size + align, nullptr);
+        if (m_head) {
+            chunk->m_next = m_head->m_next;
+            m_head->m_next = chunk;
+        } else {
+            m_head = chunk;
+            m_offset = chunk->m_size;
+        }
+        m_reserved += chunk->m_size;
+        m_used += size;
+        uintptr_t p = reinterpret_cast<uintptr_t>(chunk->data());
+        return reinterpret_cast<void*>((p + align - 1) & ~(uintptr_t(align) - 1));
+    }
+    m_head = newChunk(m_chunkSize, m_head);
+    m_reserved += m_chunkSize;
+    m_offset = 0;
+    return allocate(size, align);
+}
+
+void MemoryPool::clear() {
+    releaseAdopted();
+    // 留下一个普通大小的chunk
+    Chunk* keep = nullptr;
+    while (m_head) {
+        Chunk* next = m_head->m_next;
+        if (keep == nullptr && m_head->m_size == m_chunkSize) {
+            keep = m_head;
+        } else {
+            ::operator delete(m_head);
+        }
+        m_head = next;
+    }
+    if (keep) {
+        keep->m_next = nullptr;
+    }
+    m_head = keep;
+    m_offset = 0;
+    m_reserved = keep ? keep->m_size : 0;
+    m_used = 0;
+}
+
+void MemoryPool::splice(MemoryPool& other) {
+    if (other.m_head == nullptr) {
+        return;
+    }
+    if (m_head == nullptr) {
+        m_head = other.m_head;
+        m_offset = other.m_offset;
+    } else {
+        // other的chunk接在当前chunk后面, 不再从中分配
+        Chunk* last = other.m_head;
+        while (last->m_next) {
+            last = last->m_next;
+        }
+        last->m_next = m_head->m_next;
+        m_head->m_next = other.m_head;
+    }
+    m_reserved += other.m_reserved;
+    m_used += other.m_used;
+    other.m_head = nullptr;
+    other.m_offset = 0;
+    other.m_reserved = 0;
+    other.m_used = 0;
+}
+
+void MemoryPool::adopt(MemoryPool& other) {
+    other.retain();
+    m_adopted.push_back(&other);
+}
+
+void MemoryPool::releaseAdopted() {
+    for (MemoryPool* pool : m_adopted) {
+        pool->release();
+    }
+    m_adopted.clear();
+}
+
+size_t MemoryPool::getReserved() const {
+    size_t reserved = m_reserved;
+    for (const MemoryPool* pool : m_adopted) {
+        reserved += pool->getReserved();
+    }
+    return reserved;
+}
+
+size_t MemoryPool::getUsed() const {
+    size_t used = m_used;
+    for (const MemoryPool* pool : m_adopted) {
+        used += pool->getUsed();
+    }
+    return used;
+}
+
+}
@@ -0,0 +1,83 @@
+#ifndef CPPJSON_MEMORYPOOL_HPP
+#define CPPJSON_MEMORYPOOL_HPP
+
+#include "Nocopyable.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace cppjson {
+
+//
+// 内存池: memory is cut from chunks with a bump pointer and never freed one by one,
+// clear() releases everything at once (one chunk is kept for the next use) and so does the destructor.
+// A request bigger than half a chunk gets a chunk of its own. Not thread-safe, but retain() and release().
+// A pool made with new is reference counted: the creator holds the first reference, the last release() deletes it
+// (Document shares its pool with the Values that share its blocks this way).
+//
+class MemoryPool : public Nocopyable {
+public:
+    enum { kDefaultChunkSize = 64 * 1024 };
+
+    explicit MemoryPool(size_t chunkSize = kDefaultChunkSize);
+    ~MemoryPool();
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t offset = (m_offset + align - 1) & ~(align - 1);
+        if (m_head == nullptr || offset + size > m_head->m_size) {
+            return allocateSlow(size, align);
+        }
+        m_offset = offset + size;
+        m_used += size;
+        return m_head->data() + offset;
+    }
+
+    void clear();//也释放adopt()的pool
+
+    // takes over the chunks of other, other is left empty; what was allocated from it now lives as long as this pool
+    void splice(MemoryPool& other);
+
+    // other (made with new) lives at least as long as this pool, it keeps its chunks, so it may still be shared
+    void adopt(MemoryPool& other);
+
+    void retain() { m_refs.fetch_add(1, std::memory_order_relaxed); }
+    void release() {
+        if (m_refs.load(std::memory_order_acquire) == 1 || m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+    bool isShared() const { return m_refs.load(std::memory_order_acquire) != 1; }
+
+    size_t getChunkSize() const { return m_chunkSize; }
+    size_t getReserved() const;//bytes of all chunks
+    size_t getUsed() const;//bytes handed out
+
+private:
+    struct Chunk {
+        Chunk* m_next;
+        size_t m_size;//不含头部
+
+        char* data() { return reinterpret_cast<char*>(this) + kHeaderSize; }
+    };
+
+    enum { kHeaderSize = (sizeof(Chunk) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1) };
+
+    void* allocateSlow(size_t size, size_t align);
+    static Chunk* newChunk(size_t size, Chunk* next);
+    void releaseAdopted();
+
+private:
+    size_t m_chunkSize;
+    Chunk* m_head = nullptr;//当前分配的chunk, 单独分配的大块挂在它后面
+    size_t m_offset = 0;//m_head中已用的字节
+    size_t m_reserved = 0;
+    size_t m_used = 0;
+    std::atomic<size_t> m_refs{1};
+    std::vector<MemoryPool*> m_adopted;//各持一个引用
+};
+
+}
+
+#endif
@@ -0,0 +1,52 @@
+#include "MemoryReadStream.hpp"
+#include <cassert>
+
+namespace cppjson {
+
+bool MemoryReadStream::hasNext() {//判断是否有下一个字符
+    return m_iterator != m_end;
+}
+
+char MemoryReadStream::next() {//返回当前字符,并且itretor++
+    if (hasNext()) {
+        return *m_iterator++;
+    }
+    return '\0';
+}
+
+char MemoryReadStream::peek() {//返回当前字符
+    return hasNext() ? *m_iterator : '\0';
+}
+
+MemoryReadStream::Iterator MemoryReadStream::getIter() {
+    return m_iterator;
+}
+
+size_t MemoryReadStream::tell() {
+    return m_iterator - m_begin;
+}
+
+void MemoryReadStream::assertNext(char ch) {
+    char c = next();//NDEBUG下也要读取
+    assert(c == ch);
+    (void)c; (void)ch;
+}
+
+const char* MemoryReadStream::getPtr() {
+    return m_iterator;
+}
+
+const char* MemoryReadStream::getEnd() {
+    return m_end;
+}
+
+void MemoryReadStream::setPtr(const char* p) {
+    assert(p >= m_begin && p <= m_end);
+    m_iterator = p;
+}
+
+const char* MemoryReadStream::getBegin() {
+    return m_begin;
+}
+
+}
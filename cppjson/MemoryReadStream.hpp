@@ -0,0 +1,36 @@
+#ifndef CPPJSON_MEMORYREADSTREAM_HPP
+#define CPPJSON_MEMORYREADSTREAM_HPP
+
+#include "Nocopyable.hpp"
+#include <cstddef>
+
+namespace cppjson {
+
+// 内存输入流: reads a buffer owned by the caller without copying it
+class MemoryReadStream : public Nocopyable {
+public:
+    typedef const char* Iterator;
+private:
+    const char* m_begin;
+    const char* m_iterator;
+    const char* m_end;
+
+public:
+    MemoryReadStream(const char* json, size_t len) : m_begin(json), m_iterator(json), m_end(json + len) {}
+    bool hasNext();//判断是否有下一个字符
+    char next();//返回当前字符,并且itretor++
+    char peek();//返回当前字符
+    Iterator getIter();
+    size_t tell();//已读取的字节数
+    void assertNext(char ch);
+
+    // 连续内存: Reader uses these to scan the buffer in bulk
+    const char* getPtr();//当前读位置
+    const char* getEnd();
+    void setPtr(const char* p);//移动读位置, p必须在[getBegin(), getEnd()]之间
+    const char* getBegin();
+};
+
+}
+
+#endif
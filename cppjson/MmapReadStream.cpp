@@ -0,0 +1,100 @@
+#include "MmapReadStream.hpp"
+#include <cassert>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cppjson {
+
+MmapReadStream::MmapReadStream(const char* path, bool borrowStrings)
+    : m_mapping(nullptr), m_begin(nullptr), m_iterator(nullptr), m_end(nullptr), m_size(0), m_good(false), m_borrowStrings(borrowStrings) {
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        map(fd, 0);
+        close(fd);//映射不依赖fd
+    }
+}
+
+MmapReadStream::MmapReadStream(FILE* input, bool borrowStrings)
+    : m_mapping(nullptr), m_begin(nullptr), m_iterator(nullptr), m_end(nullptr), m_size(0), m_good(false), m_borrowStrings(borrowStrings) {
+    long offset = ftell(input);
+    if (offset >= 0) {
+        map(fileno(input), offset);
+    }
+}
+
+MmapReadStream::~MmapReadStream() {
+    if (m_size > 0) {
+        munmap(const_cast<char*>(m_mapping), m_size);
+    }
+}
+
+void MmapReadStream::map(int fd, size_t offset) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {//管道、FIFO和设备的st_size不是内容的长度
+        return;
+    }
+    if (static_cast<size_t>(st.st_size) <= offset) {//没有要读的内容, 空文件也不能映射
+        m_good = true;
+        return;
+    }
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+        return;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);//顺序读, 内核加大预读
+    m_size = st.st_size;
+    m_mapping = static_cast<const char*>(p);
+    m_begin = m_iterator = m_mapping + offset;//映射的偏移要按页对齐, 所以映射整个文件
+    m_end = m_mapping + m_size;
+    m_good = true;
+}
+
+bool MmapReadStream::hasNext() {//判断是否有下一个字符
+    return m_iterator != m_end;
+}
+
+char MmapReadStream::next() {//返回当前字符,并且itretor++
+    if (hasNext()) {
+        return *m_iterator++;
+    }
+    return '\0';
+}
+
+char MmapReadStream::peek() {//返回当前字符
+    return hasNext() ? *m_iterator : '\0';
+}
+
+MmapReadStream::Iterator MmapReadStream::getIter() {
+    return m_iterator;
+}
+
+size_t MmapReadStream::tell() {
+    return m_iterator - m_begin;
+}
+
+void MmapReadStream::assertNext(char ch) {
+    char c = next();//NDEBUG下也要读取
+    assert(c == ch);
+    (void)c; (void)ch;
+}
+
+const char* MmapReadStream::getPtr() {
+    return m_iterator;
+}
+
+const char* MmapReadStream::getEnd() {
+    return m_end;
+}
+
+void MmapReadStream::setPtr(const char* p) {
+    assert(p >= m_iterator && p <= m_end);
+    m_iterator = p;
+}
+
+const char* MmapReadStream::getBegin() {
+    return m_begin;
+}
+
+}
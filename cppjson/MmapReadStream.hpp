@@ -0,0 +1,57 @@
+#ifndef CPPJSON_MMAPREADSTREAM_HPP
+#define CPPJSON_MMAPREADSTREAM_HPP
+
+#include "Nocopyable.hpp"
+#include <cstddef>
+#include <cstdio>
+
+namespace cppjson {
+
+//
+// 内存映射输入流(POSIX): the file is mmap()ed read-only and Reader scans the mapping directly, nothing is copied.
+// The pages come from the page cache and are shared by every process mapping the same file.
+// Only regular files can be mapped, good() is false for a pipe, FIFO or device.
+//
+// borrowStrings == true: strings without escapes are handed to the handler as views into the mapping
+// (copy == false), a Document then borrows them, so the stream must outlive the document
+//
+class MmapReadStream : public Nocopyable {
+public:
+    typedef const char* Iterator;
+private:
+    const char* m_mapping;
+    const char* m_begin;//开始读的位置
+    const char* m_iterator;
+    const char* m_end;
+    size_t m_size;//映射的长度, 0表示没有映射
+    bool m_good;
+    bool m_borrowStrings;
+
+public:
+    explicit MmapReadStream(const char* path, bool borrowStrings = false);
+    explicit MmapReadStream(FILE* input, bool borrowStrings = false);//从input的当前位置(ftell)读到文件末尾, 不移动该位置
+    ~MmapReadStream();
+
+    bool good() const { return m_good; }//普通文件打开并映射成功(空文件也算)
+    bool borrowStrings() const { return m_borrowStrings; }
+
+    bool hasNext();//判断是否有下一个字符
+    char next();//返回当前字符,并且itretor++
+    char peek();//返回当前字符
+    Iterator getIter();
+    size_t tell();//已读取的字节数, 从开始读的位置算起
+    void assertNext(char ch);
+
+    // 连续内存: Reader uses these to scan the mapping in bulk
+    const char* getPtr();//当前读位置
+    const char* getEnd();
+    void setPtr(const char* p);//移动读位置, p必须在[getPtr(), getEnd()]之间
+    const char* getBegin();
+
+private:
+    void map(int fd, size_t offset);
+};
+
+}
+
+#endif
@@ -0,0 +1,26 @@
+#include "NdjsonReader.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace cppjson {
+
+std::vector<LineBatch> splitLines(const char* json, size_t len, size_t batchSize) {
+    assert(batchSize > 0);
+    std::vector<LineBatch> batches;
+    const char* end = json + len;
+    size_t line = 1;
+    for (const char* p = json; p != end; ) {
+        // batchSize字节之后的第一个'\n'结束这一批
+        const char* q = end;
+        if (static_cast<size_t>(end - p) > batchSize) {
+            const char* newline = static_cast<const char*>(memchr(p + batchSize - 1, '\n', end - (p + batchSize - 1)));
+            q = newline ? newline + 1 : end;
+        }
+        batches.push_back(LineBatch{p, q, line});
+        line += std::count(p, q, '\n');
+        p = q;
+    }
+    return batches;
+}
+
+}
@@ -0,0 +1,167 @@
+#ifndef CPPJSON_NDJSONREADER_HPP
+#define CPPJSON_NDJSONREADER_HPP
+
+#include "Exception.hpp"
+#include "Nocopyable.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace cppjson {
+
+// 一批完整的行: [m_begin, m_end) ends after a '\n' (or at the end of the input)
+struct LineBatch {
+    const char* m_begin;
+    const char* m_end;
+    size_t m_firstLine;//第一行的行号, 从1开始
+};
+
+// cuts json into batches of about batchSize bytes, each made of whole lines
+std::vector<LineBatch> splitLines(const char* json, size_t len, size_t batchSize);
+
+// calls fn(line, p, len) for every line of the batch that isn't blank
+template <typename Fn>
+void forEachLine(const LineBatch& batch, Fn&& fn) {
+    size_t line = batch.m_firstLine;
+    for (const char* p = batch.m_begin; p != batch.m_end; line++) {
+        const char* q = static_cast<const char*>(memchr(p, '\n', batch.m_end - p));
+        q = q ? q : batch.m_end;
+        if (skipWhiteSpace(p, q) != q) {
+            fn(line, p, static_cast<size_t>(q - p));
+        }
+        p = q == batch.m_end ? q : q + 1;
+    }
+}
+
+//
+// NDJSON (JSON Lines): one document per line, blank lines are skipped.
+// The input is cut into batches of lines which the threads of a ThreadPool parse in parallel.
+//
+//     NdjsonReader<TapeDocument> reader(8);
+//     MmapReadStream is("log.ndjson");
+//     reader.parse(is.getBegin(), is.getEnd() - is.getBegin(), [](size_t line, ParseError err, TapeDocument& doc) {
+//         ...
+//     });
+//
+// Doc is anything with ParseError parse(const char* json, size_t len), e.g. Document, TapeDocument, LazyDocument.
+// Every thread keeps its own Docs and reuses them for the following lines, a Doc passed to the callback is
+// only valid during the call.
+//     ordered:   the callback is called in line order, one call at a time (a thread parses up to kWindow lines
+//                of its batch ahead, then waits for the previous batches to be delivered; from then on
+//                it parses and delivers kWindow lines at a time), so a thread never holds more than kWindow Docs
+//     unordered: each thread calls the callback as soon as a line is parsed, calls run concurrently
+//
+template <typename Doc>
+class NdjsonReader : public Nocopyable {
+public:
+    enum { kDefaultBatchSize = 1024 * 1024 };
+    enum { kWindow = 16 };//ordered: 每个线程最多先解析的行数
+
+    explicit NdjsonReader(size_t threads = 0, size_t batchSize = kDefaultBatchSize)
+        : m_pool(threads), m_batchSize(batchSize), m_workers(m_pool.getSize()) {}
+
+    size_t getThreadCount() const { return m_pool.getSize(); }
+
+    // callback(size_t line, ParseError err, Doc& doc), line starts at 1
+    template <typename Callback>
+    void parse(const char* json, size_t len, Callback callback, bool ordered = true) {
+        std::vector<LineBatch> batches = splitLines(json, len, m_batchSize);
+        std::atomic<size_t> next(0);//下一个待解析的batch
+        size_t delivered = 0;//ordered: 已交付的batch数
+        std::mutex mutex;
+        std::condition_variable turn;
+
+        m_pool.run([&](size_t worker) {
+            Worker& state = m_workers[worker];
+            while (true) {
+                size_t b = next++;
+                if (b >= batches.size()) {
+                    break;
+                }
+                if (!ordered) {
+                    Doc& doc = state.doc(0);
+                    forEachLine(batches[b], [&](size_t line, const char* p, size_t n) {
+                        ParseError err = doc.parse(p, n);
+                        callback(line, err, doc);
+                    });
+                    continue;
+                }
+
+                std::exception_ptr error;
+                size_t count = 0;
+                bool myTurn = false;//之前的batch都交付了
+                auto waitTurn = [&] {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    turn.wait(lock, [&] { return delivered == b; });
+                    myTurn = true;
+                };
+                auto deliver = [&] {
+                    for (size_t i = 0; i < count; i++) {
+                        callback(state.m_results[i].first, state.m_results[i].second, state.doc(i));
+                    }
+                    count = 0;
+                };
+                try {
+                    forEachLine(batches[b], [&](size_t line, const char* p, size_t n) {
+                        if (count == kWindow) {
+                            if (!myTurn) {
+                                waitTurn();
+                            }
+                            deliver();
+                        }
+                        state.m_results[count] = std::make_pair(line, state.doc(count).parse(p, n));
+                        count++;
+                    });
+                } catch (...) {
+                    error = std::current_exception();
+                }
+
+                if (!myTurn) {
+                    waitTurn();
+                }
+                // the following batches wait for this one, it is handed over even if something threw
+                try {
+                    if (!error) {
+                        deliver();
+                    }
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                std::unique_lock<std::mutex> lock(mutex);
+                delivered++;
+                turn.notify_all();
+                if (error) {
+                    next = batches.size();//其余的batch不再解析
+                    std::rethrow_exception(error);
+                }
+            }
+        });
+    }
+
+private:
+    struct Worker {
+        std::vector<std::unique_ptr<Doc>> m_docs;//ordered模式下还没交付的每一行各用一个, 最多kWindow个
+        std::pair<size_t, ParseError> m_results[kWindow];
+
+        Doc& doc(size_t i) {
+            while (m_docs.size() <= i) {
+                m_docs.emplace_back(new Doc);
+            }
+            return *m_docs[i];
+        }
+    };
+
+    ThreadPool m_pool;
+    size_t m_batchSize;
+    std::vector<Worker> m_workers;
+};
+
+}
+
+#endif
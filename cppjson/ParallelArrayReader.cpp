@@ -0,0 +1,125 @@
+#include "ParallelArrayReader.hpp"
+#include "MemoryReadStream.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace cppjson {
+
+ParallelArrayReader::ParallelArrayReader(size_t threads, size_t batchSize)
+    : m_pool(threads), m_batchSize(batchSize) {}
+
+ParseError ParallelArrayReader::parse(const char* json, size_t len, Document& doc, size_t maxDepth) {
+    const char* p = skipWhiteSpace(json, json + len);
+    if (p == json + len || *p != '[' || maxDepth == 0) {
+        return parseSerial(json, len, doc, maxDepth);
+    }
+
+    size_t count;
+    try {
+        count = scan(json, len);
+    } catch (Exception&) {
+        return parseSerial(json, len, doc, maxDepth);//由Reader找出第一个错误
+    }
+
+    doc.reset();
+    doc.setPoolArray(count);//和元素一样在MemoryPool里, so a copy of doc shares them
+    Value::Array array = doc.getArray();
+
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::mutex mutex;
+    m_pool.run([&](size_t) {
+        // the elements are allocated from the MemoryPool of this thread's Document, which doc's pool then holds:
+        // their blocks refer to it
+        Document element;
+        element.setKeyPool(doc.getKeyPool());
+        auto adopt = [&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            doc.getPool().adopt(element.getPool());
+        };
+        try {
+            while (!failed) {
+                size_t b = next++;
+                if (b >= m_batches.size()) {
+                    break;
+                }
+                parseBatch(m_batches[b], element, array, maxDepth);
+            }
+        } catch (Exception&) {
+            failed = true;
+        } catch (...) {
+            adopt();
+            throw;
+        }
+        adopt();
+    });
+    if (failed) {
+        return parseSerial(json, len, doc, maxDepth);
+    }
+    return PARSE_OK;
+}
+
+// 一个线程, 和Reader::parse一样的maxDepth
+ParseError ParallelArrayReader::parseSerial(const char* json, size_t len, Document& doc, size_t maxDepth) {
+    MemoryReadStream is(json, len);
+    doc.reset();
+    return Reader::parse(is, doc, maxDepth);
+}
+
+size_t ParallelArrayReader::scan(const char* json, size_t len) {
+    const char* end = json + len;
+    MemoryReadStream is(json, len);
+    m_batches.clear();
+
+    const char* p = skipWhiteSpace(json, end) + 1;//'['之后
+    p = skipWhiteSpace(p, end);
+    size_t count = 0;
+    if (p != end && *p == ']') {
+        p++;
+    } else {
+        Batch batch{p, p, 0, 0};
+        while (true) {
+            is.setPtr(p);
+            Reader::skipValue(is);
+            batch.m_end = is.getPtr();
+            batch.m_count++;
+            count++;
+            p = skipWhiteSpace(batch.m_end, end);
+            if (p == end || (*p != ',' && *p != ']')) {
+                throw Exception(PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+            }
+            if (*p == ']') {
+                m_batches.push_back(batch);
+                p++;
+                break;
+            }
+            p = skipWhiteSpace(p + 1, end);
+            if (static_cast<size_t>(batch.m_end - batch.m_begin) >= m_batchSize) {
+                m_batches.push_back(batch);
+                batch = Batch{p, p, count, 0};
+            }
+        }
+    }
+    if (skipWhiteSpace(p, end) != end) {
+        throw Exception(PARSE_ROOT_NOT_SINGULAR);
+    }
+    return count;
+}
+
+void ParallelArrayReader::parseBatch(const Batch& batch, Document& element, Value::Array array, size_t maxDepth) {
+    // the pre-scan has checked the commas between the elements
+    MemoryReadStream is(batch.m_begin, batch.m_end - batch.m_begin);
+    for (size_t i = 0; i < batch.m_count; i++) {
+        if (i > 0) {
+            Reader::parseWhiteSpace(is);
+            is.next();
+            Reader::parseWhiteSpace(is);
+        }
+        element.setNull();
+        Reader::check(Reader::parseValue(is, element, maxDepth - 1));
+        Document::moveInPool(array[batch.m_first + i], element);//element's pool is adopted by doc's
+    }
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef CPPJSON_PARALLELARRAYREADER_HPP
+#define CPPJSON_PARALLELARRAYREADER_HPP
+
+#include "Document.hpp"
+#include "ThreadPool.hpp"
+#include <vector>
+
+namespace cppjson {
+
+//
+// 并行解析一个巨大的顶层数组, [ {...}, {...}, ... ], into a Document:
+//     1. a structural pre-scan (Reader::skipValue(), strings are stepped over as a whole) cuts the elements
+//        into batches of about batchSize bytes
+//     2. the threads of a ThreadPool parse the batches, every element into its own Value
+//     3. each Value is moved into its slot of the root array, which is sized up front, so the order is kept
+// Anything but an array at the root is parsed by one thread. When the input is malformed, it is parsed
+// again by Reader, the error returned is the one Reader::parse reports.
+//
+class ParallelArrayReader : public Nocopyable {
+public:
+    enum { kDefaultBatchSize = 256 * 1024 };
+
+    explicit ParallelArrayReader(size_t threads = 0, size_t batchSize = kDefaultBatchSize);
+
+    size_t getThreadCount() const { return m_pool.getSize(); }
+
+    ParseError parse(const char* json, size_t len, Document& doc, size_t maxDepth = Reader::kDefaultMaxDepth);
+
+private:
+    struct Batch {
+        const char* m_begin;//第一个元素的开始
+        const char* m_end;//最后一个元素的结尾
+        size_t m_first;//第一个元素的下标
+        size_t m_count;
+    };
+
+    static ParseError parseSerial(const char* json, size_t len, Document& doc, size_t maxDepth);
+    size_t scan(const char* json, size_t len);//returns the element count, throws on a malformed array
+    void parseBatch(const Batch& batch, Document& element, Value::Array array, size_t maxDepth);
+
+private:
+    ThreadPool m_pool;
+    size_t m_batchSize;
+    std::vector<Batch> m_batches;
+};
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+#include "PathFilter.hpp"
+
+namespace cppjson {
+
+PathFilter::PathFilter() : m_nodes(1) {}
+
+bool PathFilter::add(const std::string& pointer) {
+    if (!pointer.empty() && pointer[0] != '/') {
+        return false;
+    }
+    // 先解码全部token, a bad pointer leaves the filter unchanged
+    std::vector<std::string> tokens;
+    for (size_t i = 0; i < pointer.size(); ) {
+        std::string token;
+        for (i++; i < pointer.size() && pointer[i] != '/'; i++) {
+            if (pointer[i] != '~') {
+                token.push_back(pointer[i]);
+            } else if (i + 1 < pointer.size() && (pointer[i + 1] == '0' || pointer[i + 1] == '1')) {
+                token.push_back(pointer[++i] == '0' ? '~' : '/');
+            } else {
+                return false;
+            }
+        }
+        tokens.push_back(std::move(token));
+    }
+
+    uint32_t node = 0;
+    for (auto& token : tokens) {
+        uint32_t child = findChild(node, token.data(), token.size());
+        if (child == kNone) {
+            child = static_cast<uint32_t>(m_nodes.size());
+            m_nodes[node].m_children.emplace_back(std::move(token), child);
+            m_nodes.emplace_back();
+        }
+        node = child;
+    }
+    m_nodes[node].m_selected = true;
+    return true;
+}
+
+void PathFilter::clear() {
+    m_nodes.assign(1, Node());
+}
+
+uint32_t PathFilter::findChild(uint32_t node, const char* key, size_t len) const {
+    for (auto& child : m_nodes[node].m_children) {
+        if (child.first.size() == len && memcmp(child.first.data(), key, len) == 0) {
+            return child.second;
+        }
+    }
+    return kNone;
+}
+
+uint32_t PathFilter::findIndex(uint32_t node, size_t index) const {
+    if (m_nodes[node].m_children.empty()) {
+        return kNone;
+    }
+    // 下标按十进制比较, so "01" and "-" never match an element
+    char buf[24];
+    char* p = buf + sizeof(buf);
+    do {
+        *--p = static_cast<char>('0' + index % 10);
+        index /= 10;
+    } while (index != 0);
+    return findChild(node, p, buf + sizeof(buf) - p);
+}
+
+}
@@ -0,0 +1,184 @@
+#ifndef CPPJSON_PATHFILTER_HPP
+#define CPPJSON_PATHFILTER_HPP
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Reader.hpp"
+
+namespace cppjson {
+
+//
+// 路径过滤: only the parts of the document selected by JSON Pointers (RFC 6901) reach the handler.
+//
+//     PathFilter filter;
+//     filter.add("/data/items");
+//     filter.add("/meta/count");
+//     Document doc;
+//     filter.parse(is, doc);//doc = {"data":{"items":[...]},"meta":{"count":3}}
+//
+// A selected value is parsed by Reader as a whole. The containers on the way to a selected value are kept
+// with only the members (elements) leading there, so array elements are renumbered, and "" selects the whole document.
+// Everything else is skipped by Reader::skipValue(): brackets and quotes are checked, but strings aren't unescaped
+// and numbers aren't converted, a bad escape or number in a skipped value goes unnoticed.
+//
+class PathFilter {
+public:
+    PathFilter();
+
+    bool add(const std::string& pointer);//pointer不合法时返回false
+    void clear();
+
+    template <typename ReadStream, typename Handler>
+    ParseError parse(ReadStream& is, Handler& handler, size_t maxDepth = Reader::kDefaultMaxDepth) const {
+        try {
+            Reader::parseWhiteSpace(is);
+            walk(is, handler, maxDepth);
+            Reader::parseWhiteSpace(is);
+            if (is.hasNext()) {
+                throw Exception(PARSE_ROOT_NOT_SINGULAR);
+            }
+            return PARSE_OK;
+        } catch (Exception& e) {
+            return e.getError();
+        }
+    }
+
+private:
+#define CALL(expr) do {if (!(expr)) throw Exception(PARSE_USER_STOPPED); } while(0)
+
+    enum : uint32_t { kNone = 0xffffffff };
+
+    // 前缀树: one node per pointer prefix, node 0 is the root
+    struct Node {
+        std::vector<std::pair<std::string, uint32_t>> m_children;
+        bool m_selected = false;
+    };
+
+    // decodes the key of a member on a selected path
+    struct KeyCapture {
+        std::string m_key;
+        bool Key(const char* s, size_t len, bool) { m_key.assign(s, len); return true; }
+        bool String(const char* s, size_t len, bool copy) { return Key(s, len, copy); }
+    };
+
+    struct Frame {
+        uint32_t m_node;
+        bool m_isObject;
+        size_t m_index;//下一个元素的下标
+    };
+
+    uint32_t findChild(uint32_t node, const char* key, size_t len) const;
+    uint32_t findIndex(uint32_t node, size_t index) const;
+
+    template <typename ReadStream, typename Handler>
+    void walk(ReadStream& is, Handler& handler, size_t maxDepth) const {
+        enum State { kValue, kAfterValue, kElement, kKey };
+
+        std::vector<Frame> stack;//只有路径上的容器
+        uint32_t node = 0;//the node of the next value, kNone if nothing under it is selected
+        State state = kValue;
+        while (true) {
+            switch (state) {
+                case kValue:
+                    if (!is.hasNext()) {
+                        throw Exception(PARSE_EXPECT_VALUE);
+                    }
+                    state = kAfterValue;
+                    if (node == kNone) {
+                        Reader::skipValue(is);
+                    } else if (m_nodes[node].m_selected) {
+                        Reader::check(Reader::parseValue(is, handler, maxDepth - stack.size()));
+                    } else if (is.peek() == '[' || is.peek() == '{') {
+                        bool isObject = is.peek() == '{';
+                        if (stack.size() == maxDepth) {
+                            throw Exception(PARSE_DEPTH_EXCEEDED);
+                        }
+                        CALL(isObject ? handler.StartObject() : handler.StartArray());
+                        is.next();
+                        Reader::parseWhiteSpace(is);
+                        if (is.peek() == (isObject ? '}' : ']')) {
+                            is.next();
+                            CALL(isObject ? handler.EndObject() : handler.EndArray());
+                        } else {
+                            stack.push_back(Frame{node, isObject, 0});
+                            state = isObject ? kKey : kElement;
+                        }
+                    } else {//路径经过标量, nothing under it
+                        Reader::skipValue(is);
+                    }
+                    break;
+
+                case kElement:
+                    node = findIndex(stack.back().m_node, stack.back().m_index++);
+                    state = kValue;
+                    break;
+
+                case kKey: {
+                    if (is.peek() != '"') {
+                        throw Exception(PARSE_MISS_KEY);
+                    }
+                    const char* q = Reader::scanStringToken(is);
+                    const char* key = is.getPtr() + 1;
+                    size_t len = q - 1 - key;
+                    std::string decoded;
+                    if (memchr(key, '\\', len) == nullptr) {//没有转义, 直接比较原文
+                        node = findChild(stack.back().m_node, key, len);
+                        if (node != kNone) {
+                            decoded.assign(key, len);
+                        }
+                        is.setPtr(q);
+                    } else {
+                        KeyCapture capture;
+                        Reader::check(Reader::parseString(is, capture, true));
+                        decoded.swap(capture.m_key);
+                        node = findChild(stack.back().m_node, decoded.data(), decoded.size());
+                    }
+
+                    Reader::parseWhiteSpace(is);
+                    if (is.next() != ':') {
+                        throw Exception(PARSE_MISS_COLON);
+                    }
+                    Reader::parseWhiteSpace(is);
+                    // the key is only sent with a value that is kept
+                    if (node != kNone && (m_nodes[node].m_selected || is.peek() == '[' || is.peek() == '{')) {
+                        CALL(handler.Key(decoded.data(), decoded.size(), true));
+                    } else {
+                        node = kNone;
+                    }
+                    state = kValue;
+                    break;
+                }
+
+                case kAfterValue: {
+                    if (stack.empty()) {
+                        return;
+                    }
+                    Reader::parseWhiteSpace(is);
+                    bool isObject = stack.back().m_isObject;
+                    char ch = is.next();
+                    if (ch == ',') {
+                        Reader::parseWhiteSpace(is);
+                        state = isObject ? kKey : kElement;
+                    } else if (ch == (isObject ? '}' : ']')) {
+                        stack.pop_back();
+                        CALL(isObject ? handler.EndObject() : handler.EndArray());
+                    } else {
+                        throw Exception(isObject ? PARSE_MISS_COMMA_OR_CURLY_BRACKET : PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+#undef CALL
+
+private:
+    std::vector<Node> m_nodes;
+};
+
+}
+
+#endif
@@ -42,8 +42,17 @@ public:
         return true;
     }
 
-    bool String(std::string s) override {
-        Writer<WriterStream>::String(s);
+    bool RawNumber(const char* s, size_t len, bool copy) override {
+        Writer<WriterStream>::RawNumber(s, len, copy);
+        keepIndent();
+        return true;
+    }
+
+    using Writer<WriterStream>::String;
+    using Writer<WriterStream>::Key;
+
+    bool String(const char* s, size_t len, bool copy) override {
+        Writer<WriterStream>::String(s, len, copy);
         keepIndent();
         return true;
     }
@@ -54,9 +63,9 @@ public:
         return true;
     }
 
-    bool Key(std::string s) override {
+    bool Key(const char* s, size_t len, bool copy) override {
         m_expectObjectValue = true;
-        Writer<WriterStream>::Key(s);
+        Writer<WriterStream>::Key(s, len, copy);
         return true;
     }
 
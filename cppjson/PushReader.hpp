@@ -0,0 +1,318 @@
+#ifndef CPPJSON_PUSHREADER_HPP
+#define CPPJSON_PUSHREADER_HPP
+
+#include "Reader.hpp"
+#include "MemoryReadStream.hpp"
+#include <string>
+#include <vector>
+
+namespace cppjson {
+
+//
+// 推模式解析: the input arrives in chunks through feed(), finish() marks its end.
+//
+//     PushReader<Document> reader(document);
+//     while ((n = read(fd, buf, sizeof(buf))) > 0)
+//         if (reader.feed(buf, n) != PARSE_OK) ...
+//     ParseError err = reader.finish();
+//
+// Handler events are emitted as soon as a token is complete, with the same events and errors as Reader::parse.
+// A token cut by the end of a chunk (string, number, literal) is kept in a buffer until the rest of it arrives,
+// tokens inside a chunk are decoded in place. Memory is bounded by the longest token and the nesting depth.
+//
+template <typename Handler>
+class PushReader : public Nocopyable {
+public:
+    explicit PushReader(Handler& handler, size_t maxDepth = Reader::kDefaultMaxDepth)
+        : m_handler(handler), m_maxDepth(maxDepth) {}
+
+    // returns the first error, the chunk and every later one are then ignored
+    ParseError feed(const char* json, size_t len) {
+        if (m_error != PARSE_OK) {
+            return m_error;
+        }
+        try {
+            process(json, json + len);
+        } catch (Exception& e) {
+            m_error = e.getError();
+        }
+        return m_error;
+    }
+
+    ParseError finish() {
+        if (m_error != PARSE_OK) {
+            return m_error;
+        }
+        try {
+            if (m_state == kString || m_state == kScalar) {
+                // the token ends with the input, Reader reports what is wrong with it
+                m_state = m_state == kString ? m_tokenState : kAfterValue;
+                parseToken(m_token.data(), m_token.data() + m_token.size());
+                m_token.clear();
+            }
+            switch (m_state) {
+                case kValue:
+                case kFirstValue:
+                    throw Exception(PARSE_EXPECT_VALUE);
+                case kFirstKey:
+                case kKey:
+                    throw Exception(PARSE_MISS_KEY);
+                case kColon:
+                    throw Exception(PARSE_MISS_COLON);
+                case kAfterValue:
+                    if (!m_stack.empty()) {
+                        throw Exception(m_stack.back() == '[' ? PARSE_MISS_COMMA_OR_SQUARE_BRACKET :
+                                                                PARSE_MISS_COMMA_OR_CURLY_BRACKET);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        } catch (Exception& e) {
+            m_error = e.getError();
+        }
+        return m_error;
+    }
+
+    // ready for another document
+    void reset() {
+        m_state = kValue;
+        m_error = PARSE_OK;
+        m_stack.clear();
+        m_token.clear();
+    }
+
+private:
+#define CALL(expr) do {if (!(expr)) throw Exception(PARSE_USER_STOPPED); } while(0)
+
+    enum State {
+        kValue,       //a value is expected
+        kFirstValue,  //after '[': a value or ']'
+        kAfterValue,  //',' or the closing bracket, at the root only whitespace
+        kFirstKey,    //after '{': a key or '}'
+        kKey,         //after ',' in an object
+        kColon,
+        kString,      //inside a string cut by the end of a chunk, m_tokenState follows it
+        kScalar,      //inside a number or a literal cut by the end of a chunk
+    };
+
+    static bool isBlank(char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+    }
+
+    // p points after the opening quotation mark (or inside the string), returns the closing one or end
+    const char* scanStringEnd(const char* p, const char* end) {
+        if (m_escaped && p != end) {
+            m_escaped = false;
+            p++;
+        }
+        while (true) {
+            p = scanString(p, end);
+            if (p == end || *p == '"') {
+                return p;
+            }
+            if (*p == '\\') {
+                if (p + 1 == end) {
+                    m_escaped = true;
+                    return end;
+                }
+                p += 2;
+            } else {//控制字符, Reader reports it
+                p++;
+            }
+        }
+    }
+
+    // [begin, end) holds a whole token, Reader decodes it and the bytes it leaves belong to what follows
+    void parseToken(const char* begin, const char* end) {
+        MemoryReadStream is(begin, end - begin);
+        if (*begin == '"') {
+            Reader::check(Reader::parseString(is, m_handler, m_tokenState == kColon));
+        } else {
+            Reader::check(Reader::parseScalar(is, m_handler));
+        }
+        if (is.getPtr() != end) {
+            std::string rest(is.getPtr(), end);
+            process(rest.data(), rest.data() + rest.size());
+        }
+    }
+
+    void startString(const char* p, const char* end, State after, const char*& next) {
+        m_tokenState = after;
+        m_escaped = false;
+        const char* q = scanStringEnd(p + 1, end);
+        if (q != end) {
+            next = q + 1;
+            m_state = after;
+            parseToken(p, next);
+        } else {
+            m_token.assign(p, end);
+            m_state = kString;
+            next = end;
+        }
+    }
+
+    void startScalar(const char* p, const char* end, const char*& next) {
+        const char* q = p + 1;
+        while (q != end && !Reader::isDelimiter(*q)) {
+            q++;
+        }
+        if (q != end) {
+            next = q;
+            m_state = kAfterValue;
+            parseToken(p, q);
+        } else {
+            m_token.assign(p, end);
+            m_state = kScalar;
+            next = end;
+        }
+    }
+
+    void openContainer(char ch) {
+        if (m_stack.size() == m_maxDepth) {
+            throw Exception(PARSE_DEPTH_EXCEEDED);
+        }
+        m_stack.push_back(ch);
+        if (ch == '[') {
+            CALL(m_handler.StartArray());
+            m_state = kFirstValue;
+        } else {
+            CALL(m_handler.StartObject());
+            m_state = kFirstKey;
+        }
+    }
+
+    void closeContainer() {
+        char ch = m_stack.back();
+        m_stack.pop_back();
+        if (ch == '[') {
+            CALL(m_handler.EndArray());
+        } else {
+            CALL(m_handler.EndObject());
+        }
+        m_state = kAfterValue;
+    }
+
+    void process(const char* p, const char* end) {
+        while (p != end) {
+            if (m_state == kString) {
+                const char* q = scanStringEnd(p, end);
+                if (q == end) {
+                    m_token.append(p, end);
+                    return;
+                }
+                m_token.append(p, q + 1);
+                p = q + 1;
+                m_state = m_tokenState;
+                parseToken(m_token.data(), m_token.data() + m_token.size());
+                m_token.clear();
+                continue;
+            }
+            if (m_state == kScalar) {
+                const char* q = p;
+                while (q != end && !Reader::isDelimiter(*q)) {
+                    q++;
+                }
+                m_token.append(p, q);
+                if (q == end) {
+                    return;
+                }
+                p = q;
+                m_state = kAfterValue;
+                parseToken(m_token.data(), m_token.data() + m_token.size());
+                m_token.clear();
+                continue;
+            }
+
+            if (isBlank(*p)) {
+                p = skipWhiteSpace(p, end);
+                continue;
+            }
+            char ch = *p;
+            switch (m_state) {
+                case kFirstValue:
+                    if (ch == ']') {
+                        p++;
+                        closeContainer();
+                        break;
+                    }
+                    // fall through
+                case kValue:
+                    if (ch == '[' || ch == '{') {
+                        p++;
+                        openContainer(ch);
+                    } else if (ch == '"') {
+                        startString(p, end, kAfterValue, p);
+                    } else {
+                        startScalar(p, end, p);
+                    }
+                    break;
+
+                case kAfterValue:
+                    if (m_stack.empty()) {
+                        throw Exception(PARSE_ROOT_NOT_SINGULAR);
+                    }
+                    p++;
+                    if (m_stack.back() == '[') {
+                        if (ch == ',') {
+                            m_state = kValue;
+                        } else if (ch == ']') {
+                            closeContainer();
+                        } else {
+                            throw Exception(PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+                        }
+                    } else {
+                        if (ch == ',') {
+                            m_state = kKey;
+                        } else if (ch == '}') {
+                            closeContainer();
+                        } else {
+                            throw Exception(PARSE_MISS_COMMA_OR_CURLY_BRACKET);
+                        }
+                    }
+                    break;
+
+                case kFirstKey:
+                    if (ch == '}') {
+                        p++;
+                        closeContainer();
+                        break;
+                    }
+                    // fall through
+                case kKey:
+                    if (ch != '"') {
+                        throw Exception(PARSE_MISS_KEY);
+                    }
+                    startString(p, end, kColon, p);
+                    break;
+
+                case kColon:
+                    if (ch != ':') {
+                        throw Exception(PARSE_MISS_COLON);
+                    }
+                    p++;
+                    m_state = kValue;
+                    break;
+
+                default:
+                    assert(false && "bad state");
+            }
+        }
+    }
+
+#undef CALL
+
+private:
+    Handler& m_handler;
+    size_t m_maxDepth;
+    State m_state = kValue;
+    State m_tokenState = kValue;//state after the string in m_token, kColon for a key
+    bool m_escaped = false;//the chunk ended right after a backslash inside a string
+    ParseError m_error = PARSE_OK;
+    std::vector<char> m_stack;//'[' or '{'
+    std::string m_token;//the part of a cut token received so far
+};
+
+}
+
+#endif
@@ -1,27 +1,81 @@
 #include "Reader.hpp"
 #include <cassert>
+#include <cstring>
 
 namespace cppjson {
 
-void Reader::encodeUtf8(std::string& buffer, unsigned u) {
+unsigned Reader::encodeUtf8(char* buf, unsigned u) {
         // unicode stuff from Milo's tutorial
     switch (u) {
         case 0x00 ... 0x7F:
-            buffer.push_back(u & 0xFF); break;
+            buf[0] = u & 0xFF;
+            return 1;
         case 0x080 ... 0x7FF:
-            buffer.push_back(0xC0 | ((u >> 6) & 0xFF));
-            buffer.push_back(0x80 | (u & 0x3F)); break;
+            buf[0] = 0xC0 | ((u >> 6) & 0xFF);
+            buf[1] = 0x80 | (u & 0x3F);
+            return 2;
         case 0x0800 ... 0xFFFF:
-            buffer.push_back(0xE0 | ((u >> 12) & 0xFF));
-            buffer.push_back(0x80 | ((u >> 6) & 0x3F));
-            buffer.push_back(0x80 | (u & 0x3F)); break;
+            buf[0] = 0xE0 | ((u >> 12) & 0xFF);
+            buf[1] = 0x80 | ((u >> 6) & 0x3F);
+            buf[2] = 0x80 | (u & 0x3F);
+            return 3;
         case 0x010000 ... 0x10FFFF:
-            buffer.push_back(0xF0 | ((u >> 18) & 0xFF));
-            buffer.push_back(0x80 | ((u >> 12) & 0x3F));
-            buffer.push_back(0x80 | ((u >> 6) & 0x3F));
-            buffer.push_back(0x80 | (u & 0x3F)); break;
+            buf[0] = 0xF0 | ((u >> 18) & 0xFF);
+            buf[1] = 0x80 | ((u >> 12) & 0x3F);
+            buf[2] = 0x80 | ((u >> 6) & 0x3F);
+            buf[3] = 0x80 | (u & 0x3F);
+            return 4;
         default: assert(false && "out of range");//never reach
     }
+    return 0;
+}
+
+void Reader::locateLine(const char* begin, const char* p, ParseResult& result) {
+    size_t line = 1;
+    const char* lineBegin = begin;
+    for (const char* q = begin; (q = static_cast<const char*>(memchr(q, '\n', p - q))) != nullptr; ) {
+        line++;
+        lineBegin = ++q;
+    }
+    result.m_line = line;
+    result.m_column = p - lineBegin + 1;
+}
+
+// RFC 3629: no overlong forms, no surrogates, nothing above U+10FFFF
+bool Reader::isValidUtf8(const char* s, size_t len) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
+    const unsigned char* end = p + len;
+    while (p != end) {
+        if (*p < 0x80) {
+            p++;
+            continue;
+        }
+        unsigned char lo = 0x80, hi = 0xBF;//第二个字节的范围
+        size_t n;//后续字节数
+        if (*p >= 0xC2 && *p <= 0xDF) {
+            n = 1;
+        } else if (*p >= 0xE0 && *p <= 0xEF) {
+            n = 2;
+            lo = *p == 0xE0 ? 0xA0 : 0x80;
+            hi = *p == 0xED ? 0x9F : 0xBF;
+        } else if (*p >= 0xF0 && *p <= 0xF4) {
+            n = 3;
+            lo = *p == 0xF0 ? 0x90 : 0x80;
+            hi = *p == 0xF4 ? 0x8F : 0xBF;
+        } else {
+            return false;
+        }
+        if (static_cast<size_t>(end - p) <= n || p[1] < lo || p[1] > hi) {
+            return false;
+        }
+        for (size_t i = 2; i <= n; i++) {
+            if ((p[i] & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        p += n + 1;
+    }
+    return true;
 }
 
 }
\ No newline at end of file
@@ -3,22 +3,92 @@
 #include "Value.hpp"
 #include "Exception.hpp"
 #include "Nocopyable.hpp"
+#include "InsituStringStream.hpp"
+#include "Simd.hpp"
+#include "Strtod.hpp"
 #include <limits>
 #include <cmath>
-#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace cppjson {
 
+// a ReadStream backed by contiguous memory exposes getPtr()/getEnd()/setPtr(),
+// Reader then works on the raw bytes instead of going through peek()/next()
+template <typename ReadStream, typename = void>
+struct IsContiguousStream : std::false_type {};
+
+template <typename ReadStream>
+struct IsContiguousStream<ReadStream, decltype((void)std::declval<ReadStream&>().getPtr())> : std::true_type {};
+
+// a contiguous ReadStream that holds only a window of its input also exposes refill(),
+// which keeps [getPtr(), getEnd()) and appends more input to it (the window may move), false at the end of input
+template <typename ReadStream, typename = void>
+struct IsRefillableStream : std::false_type {};
+
+template <typename ReadStream>
+struct IsRefillableStream<ReadStream, decltype((void)std::declval<ReadStream&>().refill())> : std::true_type {};
+
+// a contiguous ReadStream whose bytes outlive the parse may expose borrowStrings(),
+// strings without escapes are then passed to the handler as views into the input (copy == false)
+template <typename ReadStream, typename = void>
+struct IsBorrowingStream : std::false_type {};
+
+template <typename ReadStream>
+struct IsBorrowingStream<ReadStream, decltype((void)std::declval<ReadStream&>().borrowStrings())> : std::true_type {};
+
+// a Handler that takes String/Key(const char*, size_t, bool copy), the contract every engine here speaks
+template <typename Handler, typename = void>
+struct IsViewHandler : std::false_type {};
+
+template <typename Handler>
+struct IsViewHandler<Handler, decltype((void)std::declval<Handler&>().String(static_cast<const char*>(nullptr), size_t(0), false))>
+    : std::true_type {};
+
+// a contiguous ReadStream whose input before the read position is still there, unchanged, exposes getBegin(),
+// the line and column of an error are counted in it
+template <typename ReadStream, typename = void>
+struct IsWholeInputStream : std::false_type {};
+
+template <typename ReadStream>
+struct IsWholeInputStream<ReadStream, decltype((void)std::declval<ReadStream&>().getBegin())> : std::true_type {};
+
+// 语法开关, Reader::parse<flags>(): a feature left out is compiled away, the grammar then rejects it
+enum ParseFlag {
+    kParseStrict = 0,//RFC 8259, 没有扩展
+    kParseNanInf = 1,//NaN, Infinity
+    kParseIntSuffix = 2,//整数后缀 i32, i64
+    kParseComments = 4,//注释 // 和 /* */, 可出现在任何空白处
+    kParseTrailingCommas = 8,//数组和对象的最后一个元素之后可以有逗号
+    kParseValidateUtf8 = 16,//字符串(解码之后)必须是合法的UTF-8, 否则PARSE_BAD_UTF8
+    kParseRawNumbers = 32,//数字不转换, 原文交给Handler::RawNumber(const char*, size_t, bool copy), 只检查整数的范围(超出范围的double如1e309不报错)
+    kParseDefault = kParseNanInf | kParseIntSuffix,
+};
+
+#define CALL(expr) do {if (!(expr)) return PARSE_USER_STOPPED; } while(0)
+#define CHECK_PARSE(expr) do { ParseError parseError = (expr); if (parseError != PARSE_OK) return parseError; } while(0)
+
 class Reader : public Nocopyable {
+    friend class IndexReader;
+    friend class ParallelArrayReader;
+    friend class PathFilter;
+    template <typename Handler> friend class PushReader;
+    friend class LazyValue;
+    friend class LazyArrayIterator;
+    friend class LazyMemberIterator;
 public:
-    template <typename ReadStream, typename Handler>
-    static ParseError parse(ReadStream& is, Handler& handler) {
+    enum { kDefaultMaxDepth = 1024 };
+
+    // maxDepth: arrays/objects nested deeper than this fail with PARSE_DEPTH_EXCEEDED
+    // errors are passed up as return codes, only an Exception thrown by the handler itself is caught
+    template <unsigned parseFlags = kParseDefault, typename ReadStream, typename Handler>
+    static ParseError parse(ReadStream& is, Handler& handler, size_t maxDepth = kDefaultMaxDepth) {
         try {
-            parseWhiteSpace(is);
-            parseValue(is, handler);
-            parseWhiteSpace(is);
+            parseWhiteSpace<parseFlags>(is);
+            CHECK_PARSE(parseValue<parseFlags>(is, handler, maxDepth));
+            parseWhiteSpace<parseFlags>(is);
             if (is.hasNext()) {
-                throw Exception(PARSE_ROOT_NOT_SINGULAR);
+                return PARSE_ROOT_NOT_SINGULAR;
             }
             return PARSE_OK;
         } catch (Exception& e) {
@@ -26,11 +96,96 @@ public:
         }
     }
 
+    // also reports where the parse stopped, see ParseResult
+    template <unsigned parseFlags = kParseDefault, typename ReadStream, typename Handler>
+    static ParseError parse(ReadStream& is, Handler& handler, ParseResult& result, size_t maxDepth = kDefaultMaxDepth) {
+        result = ParseResult();
+        result.m_error = parse<parseFlags>(is, handler, maxDepth);
+        if (result.m_error != PARSE_OK) {
+            locate(is, result, IsWholeInputStream<ReadStream>());
+        }
+        return result.m_error;
+    }
+
 private:
-#define CALL(expr) do {if (!(expr)) throw Exception(PARSE_USER_STOPPED); } while(0)
+    // for the friends that report errors by Exception
+    static void check(ParseError err) {
+        if (err != PARSE_OK) {
+            throw Exception(err);
+        }
+    }
 
+    // the input before the read position is intact: line and column are counted in it
     template <typename ReadStream>
+    static void locate(ReadStream& is, ParseResult& result, std::true_type) {
+        result.m_offset = is.tell();
+        locateLine(is.getBegin(), is.getPtr(), result);
+    }
+
+    template <typename ReadStream>
+    static void locate(ReadStream& is, ParseResult& result, std::false_type) {
+        result.m_offset = is.tell();
+    }
+
+    template <unsigned parseFlags = kParseDefault, typename ReadStream>
     static void parseWhiteSpace(ReadStream& is) {
+        parseWhiteSpace(is, IsContiguousStream<ReadStream>());
+        if (parseFlags & kParseComments) {
+            while (is.peek() == '/' && skipComment(is)) {
+                parseWhiteSpace(is, IsContiguousStream<ReadStream>());
+            }
+        }
+    }
+
+    // '/' at the read position: // runs to the end of the line, /* */ to the closing */.
+    // Anything else (or an unclosed comment) is consumed and false returned, the parse then fails on what follows.
+    template <typename ReadStream>
+    static bool skipComment(ReadStream& is) {
+        is.next();
+        if (is.peek() == '/') {
+            while (is.hasNext() && is.next() != '\n') {}
+            return true;
+        }
+        if (is.peek() == '*') {
+            is.next();
+            while (is.hasNext()) {
+                if (is.next() == '*' && is.peek() == '/') {
+                    is.next();
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    template <typename ReadStream>
+    static void parseWhiteSpace(ReadStream& is, std::true_type) {
+        char ch = is.peek();
+        if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+            while (true) {
+                const char* p = skipWhiteSpace(is.getPtr(), is.getEnd());
+                is.setPtr(p);
+                if (p != is.getEnd() || !refill(is)) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // the end of the window isn't the end of the input for a refillable stream
+    template <typename ReadStream>
+    static bool refill(ReadStream& is) {
+        return refill(is, IsRefillableStream<ReadStream>());
+    }
+
+    template <typename ReadStream>
+    static bool refill(ReadStream& is, std::true_type) { return is.refill(); }
+
+    template <typename ReadStream>
+    static bool refill(ReadStream&, std::false_type) { return false; }
+
+    template <typename ReadStream>
+    static void parseWhiteSpace(ReadStream& is, std::false_type) {
         while (is.hasNext()) {
             char ch = is.peek();
             if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
@@ -41,24 +196,26 @@ private:
         }
     }
 
-    template <typename ReadStream, typename Handler>
-    static void parseValue(ReadStream& is, Handler& handler) {
-        if (!is.hasNext())
-            throw Exception(PARSE_EXPECT_VALUE);//没有可解析的json
+    // 标量: anything but an array or an object, the stream must not be at the end
+    template <unsigned parseFlags = kParseDefault, typename ReadStream, typename Handler>
+    static ParseError parseScalar(ReadStream& is, Handler& handler) {
+        std::string buffer;
+        return parseScalar<parseFlags>(is, handler, buffer);
+    }
 
+    template <unsigned parseFlags = kParseDefault, typename ReadStream, typename Handler>
+    static ParseError parseScalar(ReadStream& is, Handler& handler, std::string& buffer) {
         switch (is.peek()) {
             case 'n': return parseLiteral(is, handler, "null", TYPE_NULL);
             case 't': return parseLiteral(is, handler, "true", TYPE_BOOL);
             case 'f': return parseLiteral(is, handler, "false", TYPE_BOOL);
-            case '\"': return parseString(is, handler, false);
-            case '[': return parseArray(is, handler);
-            case '{': return parseObject(is, handler);
-            default:  return parseNumber(is, handler);
+            case '\"': return parseString<parseFlags>(is, handler, false, buffer);
+            default:  return parseNumber<parseFlags>(is, handler);
         }
     }
 
     template <typename ReadStream, typename Handler>
-    static void parseLiteral(ReadStream& is, Handler& handler, const char* literal, ValueType type) {
+    static ParseError parseLiteral(ReadStream& is, Handler& handler, const char* literal, ValueType type) {
         char c = *literal;
 
         is.assertNext(*literal++);
@@ -70,283 +227,743 @@ private:
             switch (type) {
                 case TYPE_NULL:
                     CALL(handler.Null());
-                    return;
+                    return PARSE_OK;
                 case TYPE_BOOL:
                     CALL(handler.Bool(c == 't'));
-                    return;
+                    return PARSE_OK;
                 case TYPE_DOUBLE:
                     CALL(handler.Double(c == 'N' ? NAN : INFINITY));
-                    return;
+                    return PARSE_OK;
                 default:
                     assert(false && "bad type");//never reach
             }
         }
-        throw Exception(PARSE_BAD_VALUE);
+        return PARSE_BAD_VALUE;
     }
 
-    template <typename ReadStream, typename Handler>
-    static void parseNumber(ReadStream& is, Handler& handler) {
+    template <unsigned parseFlags, typename ReadStream, typename Handler>
+    static ParseError parseNumber(ReadStream& is, Handler& handler) {
         // parse 'NaN' (Not a Number) && 'Infinity'
-        if (is.peek() == 'N') {
-            parseLiteral(is, handler, "NaN", TYPE_DOUBLE);
-            return;
+        if ((parseFlags & kParseNanInf) && is.peek() == 'N') {
+            return parseLiteral(is, handler, "NaN", TYPE_DOUBLE);
         }
-        else if (is.peek() == 'I') {
-            parseLiteral(is, handler, "Infinity", TYPE_DOUBLE);
-            return;
+        else if ((parseFlags & kParseNanInf) && is.peek() == 'I') {
+            return parseLiteral(is, handler, "Infinity", TYPE_DOUBLE);
         }
+        return parseNumber<parseFlags>(is, handler, IsContiguousStream<ReadStream>());
+    }
 
-        auto start = is.getIter();
+    // a number that reaches the end of the window may go on after it, it is scanned again once the window is refilled
+    template <unsigned parseFlags, typename ReadStream, typename Handler>
+    static ParseError parseNumber(ReadStream& is, Handler& handler, std::true_type) {
+        bool more = IsRefillableStream<ReadStream>::value;//refill() may move the window even when it fails, so scan again
+        while (true) {
+            MemoryCursor cursor{is.getPtr(), is.getEnd()};
+            const char* start = cursor.m_p;
+            Number number;
+            ParseError err = scanNumber<parseFlags>(cursor, number);
+            if (more && cursor.m_p == cursor.m_end) {
+                more = refill(is);
+                continue;
+            }
+            is.setPtr(cursor.m_p);//出错时停在出错的字符上
+            CHECK_PARSE(err);
+            return putNumber(handler, number, start, cursor.m_p - start, !borrowStrings(is, IsBorrowingStream<ReadStream>()),
+                             std::integral_constant<bool, (parseFlags & kParseRawNumbers) != 0>());
+        }
+    }
 
-        if (is.peek() == '-') {
-            is.next();
+    template <unsigned parseFlags, typename ReadStream, typename Handler>
+    static ParseError parseNumber(ReadStream& is, Handler& handler, std::false_type) {
+        StreamCursor<ReadStream> cursor{is, std::string()};
+        Number number;
+        CHECK_PARSE(scanNumber<parseFlags>(cursor, number));
+        return putNumber(handler, number, cursor.m_text.data(), cursor.m_text.size(), true,
+                         std::integral_constant<bool, (parseFlags & kParseRawNumbers) != 0>());
+    }
+
+    // a number as found by scanNumber(): significand * 10^exponent
+    struct Number {
+        bool negative;
+        uint64_t significand;//前19位有效数字
+        int64_t exponent;
+        bool truncated;//19位之后还有非0的数字
+        bool integerTooLong;//整数部分超过19位
+        ValueType type;//TYPE_NULL: 整数, 没有i32/i64后缀
+    };
+
+    struct MemoryCursor {
+        const char* m_p;
+        const char* m_end;
+        char peek() const { return m_p != m_end ? *m_p : '\0'; }
+        void next() { m_p++; }
+    };
+
+    // keeps the characters, the slow path of convertNumber() needs the text
+    template <typename ReadStream>
+    struct StreamCursor {
+        ReadStream& m_is;
+        std::string m_text;
+        char peek() { return m_is.peek(); }
+        void next() { m_text.push_back(m_is.next()); }
+    };
+
+    // validates the number and accumulates its digits in the same pass
+    template <unsigned parseFlags, typename Cursor>
+    static ParseError scanNumber(Cursor& c, Number& n) {
+        static const int kMaxDigits = 19;//uint64_t能放下的十进制位数
+        n = {false, 0, 0, false, false, TYPE_NULL};
+        int digits = 0;//有效数字的个数
+        int64_t exponent = 0;
+
+        if (c.peek() == '-') {
+            n.negative = true;
+            c.next();
         }
 
-        if (is.peek() == '0') {
-            is.next();
-            if (isdigit(is.peek()))
-                throw Exception(PARSE_BAD_VALUE);
-        } else if (isDigit19(is.peek())) {
-            is.next();
-            while (isDigit(is.peek()))
-                is.next();
+        if (c.peek() == '0') {
+            c.next();
+            if (isDigit(c.peek()))
+                return PARSE_BAD_VALUE;
+        } else if (isDigit19(c.peek())) {
+            int integerDigits = 0;
+            for (char ch = c.peek(); isDigit(ch); ch = c.peek()) {
+                if (digits < kMaxDigits) {
+                    n.significand = n.significand * 10 + (ch - '0');
+                    digits++;
+                } else {
+                    exponent++;
+                    n.truncated |= ch != '0';
+                }
+                integerDigits++;
+                c.next();
+            }
+            n.integerTooLong = integerDigits > kMaxDigits;
         } else {
-            throw Exception(PARSE_BAD_VALUE);
+            return PARSE_BAD_VALUE;
         }
 
-        auto expectType = TYPE_NULL;
-
-        if (is.peek() == '.') {
-            expectType = TYPE_DOUBLE;//浮点数
-            is.next();
-            if (!isDigit(is.peek())) {
-                throw Exception(PARSE_BAD_VALUE);
+        if (c.peek() == '.') {
+            n.type = TYPE_DOUBLE;//浮点数
+            c.next();
+            if (!isDigit(c.peek())) {
+                return PARSE_BAD_VALUE;
             }
-            is.next();
-            while (isDigit(is.peek())) {
-                is.next();
+            for (char ch = c.peek(); isDigit(ch); ch = c.peek()) {
+                if (digits < kMaxDigits) {
+                    if (n.significand != 0 || ch != '0') {//前导0不算有效数字
+                        digits++;
+                    }
+                    n.significand = n.significand * 10 + (ch - '0');
+                    exponent--;
+                } else {
+                    n.truncated |= ch != '0';
+                }
+                c.next();
             }
         }
 
-        if (is.peek() == 'e' || is.peek() == 'E') {
-            expectType = TYPE_DOUBLE;//浮点数
-            is.next();
-            if (is.peek() == '+' || is.peek() == '-') {
-                is.next();
+        if (c.peek() == 'e' || c.peek() == 'E') {
+            n.type = TYPE_DOUBLE;//浮点数
+            c.next();
+            bool negativeExponent = false;
+            if (c.peek() == '+' || c.peek() == '-') {
+                negativeExponent = c.peek() == '-';
+                c.next();
             }
 
-            if (!isDigit(is.peek())) {
-                throw Exception(PARSE_BAD_VALUE);
+            if (!isDigit(c.peek())) {
+                return PARSE_BAD_VALUE;
             }
 
-            is.next();
-            while (isDigit(is.peek())) {
-                is.next();
+            int64_t e = 0;
+            for (char ch = c.peek(); isDigit(ch); ch = c.peek()) {
+                if (e < 100000) {//再大的指数也只是0或者inf
+                    e = e * 10 + (ch - '0');
+                }
+                c.next();
             }
+            exponent += negativeExponent ? -e : e;
         }
+        n.exponent = exponent;
 
         // int64 or int32 ? 这个标志可以不写
-        if (is.peek() == 'i') {
-            is.next();
-            if (expectType == TYPE_DOUBLE) {//整数，非浮点数
-                throw Exception(PARSE_BAD_VALUE);
+        if ((parseFlags & kParseIntSuffix) && c.peek() == 'i') {
+            c.next();
+            if (n.type == TYPE_DOUBLE) {//整数，非浮点数
+                return PARSE_BAD_VALUE;
             }
-            switch (is.next()) {
+            switch (c.peek()) {
                 case '3':
-                    if (is.next() != '2') {
-                        throw Exception(PARSE_BAD_VALUE);
+                    c.next();
+                    if (c.peek() != '2') {
+                        return PARSE_BAD_VALUE;
                     }
-                    expectType = TYPE_INT32;
+                    c.next();
+                    n.type = TYPE_INT32;
                     break;
                 case '6':
-                    if (is.next() != '4') {
-                        throw Exception(PARSE_BAD_VALUE);
+                    c.next();
+                    if (c.peek() != '4') {
+                        return PARSE_BAD_VALUE;
                     }
-                    expectType = TYPE_INT64;
+                    c.next();
+                    n.type = TYPE_INT64;
                     break;
                 default:
-                    throw Exception(PARSE_BAD_VALUE);
+                    return PARSE_BAD_VALUE;
             }
         }
+        return PARSE_OK;
+    }
+
+    template <typename Handler>
+    static ParseError putNumber(Handler& handler, const Number& n, const char* text, size_t len, bool, std::false_type) {
+        return convertNumber(handler, n, text, len);
+    }
 
-        auto end = is.getIter();
-        if (start == end) {
-            throw Exception(PARSE_BAD_VALUE);
+    // kParseRawNumbers: the text goes to the handler, a double is converted only when it is read
+    template <typename Handler>
+    static ParseError putNumber(Handler& handler, const Number& n, const char* text, size_t len, bool copy, std::true_type) {
+        if (n.type != TYPE_DOUBLE) {
+            const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + n.negative;
+            const uint64_t limit32 = static_cast<uint64_t>(std::numeric_limits<int32_t>::max()) + n.negative;
+            if (n.integerTooLong || n.significand > (n.type == TYPE_INT32 ? limit32 : limit)) {
+                return PARSE_NUMBER_TOO_BIG;
+            }
         }
+        CALL(handler.RawNumber(text, len, copy));
+        return PARSE_OK;
+    }
 
-        try {
-            //
-            // std::stod() && std::stoi() are bad ideas,
-            // because new string buffer is needed
-            //
-            std::size_t idx;
-            if (expectType == TYPE_DOUBLE) {
-                double d = __gnu_cxx::__stoa(&std::strtod, "stod", &*start, &idx);
-                assert(start + idx == end);
-                CALL(handler.Double(d));
-            }
-
-            else {
-                int64_t i64 = __gnu_cxx::__stoa(&std::strtol, "stol", &*start, &idx, 10);
-                if (expectType == TYPE_INT64) {
-                    CALL(handler.Int64(i64));
-                } else if (expectType == TYPE_INT32) {
-                    if (i64 > std::numeric_limits<int32_t>::max() || i64 < std::numeric_limits<int32_t>::min()) {
-                        throw std::out_of_range("int32_t overflow");
-                    }
-                    CALL(handler.Int32(static_cast<int32_t>(i64)));
-                } else if (i64 <= std::numeric_limits<int32_t>::max() && i64 >= std::numeric_limits<int32_t>::min()) {
-                    CALL(handler.Int32(static_cast<int32_t>(i64)));
-                } else {
-                    CALL(handler.Int64(i64));
-                }
+    template <typename Handler>
+    static ParseError convertNumber(Handler& handler, const Number& n, const char* text, size_t len) {
+        if (n.type == TYPE_DOUBLE) {
+            double d;
+            if (!fastStrtod(n.significand, n.exponent, n.negative, n.truncated, &d)) {
+                d = slowStrtod(text, len);
+            }
+            if (std::isinf(d)) {
+                return PARSE_NUMBER_TOO_BIG;
+            }
+            CALL(handler.Double(d));
+            return PARSE_OK;
+        }
+
+        // -2^63 has no positive int64_t counterpart
+        const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + n.negative;
+        if (n.integerTooLong || n.significand > limit) {
+            return PARSE_NUMBER_TOO_BIG;
+        }
+        int64_t i64 = n.negative ? static_cast<int64_t>(0 - n.significand) : static_cast<int64_t>(n.significand);
+        bool fitsInt32 = i64 <= std::numeric_limits<int32_t>::max() && i64 >= std::numeric_limits<int32_t>::min();
+        if (n.type == TYPE_INT64) {
+            CALL(handler.Int64(i64));
+        } else if (n.type == TYPE_INT32) {
+            if (!fitsInt32) {
+                return PARSE_NUMBER_TOO_BIG;
             }
-        } catch (std::exception &e) {
-            throw Exception(PARSE_NUMBER_TOO_BIG);
+            CALL(handler.Int32(static_cast<int32_t>(i64)));
+        } else if (fitsInt32) {
+            CALL(handler.Int32(static_cast<int32_t>(i64)));
+        } else {
+            CALL(handler.Int64(i64));
         }
+        return PARSE_OK;
     }
 
-    template <typename ReadStream, typename Handler>
-    static void parseString(ReadStream& is, Handler& handler, bool isKey) {
-        is.assertNext('\"');
+    // SAX contract: String/Key(const char* s, size_t len, bool copy). With copy == true s is only valid during the call,
+    // with copy == false it points into input that outlives the parse (borrowStrings(), in-situ)
+    template <unsigned parseFlags = kParseDefault, typename ReadStream, typename Handler>
+    static ParseError parseString(ReadStream& is, Handler& handler, bool isKey) {
         std::string buffer;
+        return parseString<parseFlags>(is, handler, isKey, buffer);
+    }
+
+    // buffer: a string that can't be passed as a view is decoded into it, reused from string to string
+    template <unsigned parseFlags = kParseDefault, typename ReadStream, typename Handler>
+    static ParseError parseString(ReadStream& is, Handler& handler, bool isKey, std::string& buffer) {
+        static_assert(IsViewHandler<Handler>::value,
+                      "Handler::String/Key take (const char*, size_t, bool copy), wrap a std::string handler in StringHandlerAdapter");
+        is.assertNext('\"');
+        buffer.clear();
+        bool done = false;
+        CHECK_PARSE(viewString<parseFlags>(is, handler, isKey, buffer, done, IsContiguousStream<ReadStream>()));
+        if (done) {
+            return PARSE_OK;
+        }
+        CHECK_PARSE(parseStringContent(is, buffer));
+        CHECK_PARSE(validateUtf8<parseFlags>(buffer.data(), buffer.size()));
+        return putString(handler, isKey, buffer.data(), buffer.size(), true);
+    }
+
+    // the string is a plain run up to the closing quotation mark: the handler gets a view into the stream,
+    // otherwise the run found so far starts the buffer
+    template <unsigned parseFlags, typename ReadStream, typename Handler>
+    static ParseError viewString(ReadStream& is, Handler& handler, bool isKey, std::string& buffer, bool& done, std::true_type) {
+        const char* p = is.getPtr();
+        const char* q = scanString(p, is.getEnd());
+        if (q == is.getEnd() || *q != '"') {
+            buffer.assign(p, q);
+            is.setPtr(q);
+            return PARSE_OK;
+        }
+        is.setPtr(q + 1);
+        done = true;
+        CHECK_PARSE(validateUtf8<parseFlags>(p, q - p));
+        return putString(handler, isKey, p, q - p, !borrowStrings(is, IsBorrowingStream<ReadStream>()));
+    }
+
+    template <unsigned parseFlags, typename ReadStream, typename Handler>
+    static ParseError viewString(ReadStream&, Handler&, bool, std::string&, bool&, std::false_type) {
+        return PARSE_OK;
+    }
+
+    template <typename ReadStream>
+    static bool borrowStrings(ReadStream& is, std::true_type) { return is.borrowStrings(); }
+
+    template <typename ReadStream>
+    static bool borrowStrings(ReadStream&, std::false_type) { return false; }
+
+    template <typename Handler>
+    static ParseError putString(Handler& handler, bool isKey, const char* s, size_t len, bool copy) {
+        if (isKey) {
+            CALL(handler.Key(s, len, copy));
+        } else {
+            CALL(handler.String(s, len, copy));
+        }
+        return PARSE_OK;
+    }
+
+    // in-situ: escapes are decoded into the input buffer, handlers get views into it (copy == false)
+    template <unsigned parseFlags = kParseDefault, typename Handler>
+    static ParseError parseString(InsituStringStream& is, Handler& handler, bool isKey, std::string&) {
+        is.assertNext('\"');
+        const char* str = is.putBegin();
+        CHECK_PARSE(parseStringContent(is, is));
+        size_t len = is.putEnd();
+        CHECK_PARSE(validateUtf8<parseFlags>(str, len));
+        return putString(handler, isKey, str, len, false);
+    }
+
+    // escapes decode to well-formed UTF-8 except for a lone surrogate, so checking the decoded string covers both
+    template <unsigned parseFlags>
+    static ParseError validateUtf8(const char* s, size_t len) {
+        if ((parseFlags & kParseValidateUtf8) && !isValidUtf8(s, len)) {
+            return PARSE_BAD_UTF8;
+        }
+        return PARSE_OK;
+    }
+
+    template <typename ReadStream, typename Buffer>
+    static ParseError parseStringContent(ReadStream& is, Buffer& buffer) {
+        return parseStringContent(is, buffer, IsContiguousStream<ReadStream>());
+    }
+
+    // runs without '"', '\\' or control characters are found by scanString() and copied in one go,
+    // only the character that stopped the scan goes through parseStringChar()
+    template <typename ReadStream, typename Buffer>
+    static ParseError parseStringContent(ReadStream& is, Buffer& buffer, std::true_type) {
+        while (true) {
+            const char* p = is.getPtr();
+            const char* end = is.getEnd();
+            const char* special = scanString(p, end);
+            is.setPtr(special);
+            putRun(buffer, p, special - p);
+            if (special == end) {
+                if (refill(is)) {
+                    continue;
+                }
+                return PARSE_MISS_QUOTATION_MARK;
+            }
+            bool closed = false;
+            CHECK_PARSE(parseStringChar(is, buffer, is.next(), closed));
+            if (closed) {
+                return PARSE_OK;
+            }
+        }
+    }
+
+    template <typename ReadStream, typename Buffer>
+    static ParseError parseStringContent(ReadStream& is, Buffer& buffer, std::false_type) {
         while (is.hasNext()) {
-            switch (char ch = is.next()) {
-                case '"':
-                    if (isKey) {
-                        CALL(handler.Key(std::move(buffer)));
+            bool closed = false;
+            CHECK_PARSE(parseStringChar(is, buffer, is.next(), closed));
+            if (closed) {
+                return PARSE_OK;
+            }
+        }
+        return PARSE_MISS_QUOTATION_MARK;
+    }
+
+    // closed: set on the closing quotation mark
+    template <typename ReadStream, typename Buffer>
+    static ParseError parseStringChar(ReadStream& is, Buffer& buffer, char ch, bool& closed) {
+        switch (ch) {
+            case '"':
+                closed = true;
+                return PARSE_OK;
+            case '\x01'...'\x1f'://小于0x20
+                return PARSE_BAD_STRING_CHAR;
+            case '\\'://转义符
+                switch (is.next()) {
+                    case '"':  putChar(buffer, '"');  break;
+                    case '\\': putChar(buffer, '\\'); break;
+                    case '/':  putChar(buffer, '/');  break;
+                    case 'b':  putChar(buffer, '\b'); break;
+                    case 'f':  putChar(buffer, '\f'); break;
+                    case 'n':  putChar(buffer, '\n'); break;
+                    case 'r':  putChar(buffer, '\r'); break;
+                    case 't':  putChar(buffer, '\t'); break;
+                    case 'u': {
+                        // unicode stuff from Milo's tutorial
+                        unsigned u;
+                        CHECK_PARSE(parseHex4(is, u));
+                        if (u >= 0xD800 && u <= 0xDBFF) {
+                            if (is.next() != '\\')
+                                return PARSE_BAD_UNICODE_SURROGATE;
+                            if (is.next() != 'u')
+                                return PARSE_BAD_UNICODE_SURROGATE;
+                            unsigned u2;
+                            CHECK_PARSE(parseHex4(is, u2));
+                            if (u2 >= 0xDC00 && u2 <= 0xDFFF)
+                                u = 0x10000 + (u - 0xD800) * 0x400 + (u2 - 0xDC00);
+                            else
+                                return PARSE_BAD_UNICODE_SURROGATE;
+                        }
+                        char utf8[4];
+                        putRun(buffer, utf8, encodeUtf8(utf8, u));
+                        break;
                     }
-                    else {
-                        CALL(handler.String(std::move(buffer)));
+                    default: return PARSE_BAD_STRING_ESCAPE;
+                }
+                break;
+            default: putChar(buffer, ch);//普通字符
+        }
+        return PARSE_OK;
+    }
+
+    //
+    // 非递归: one value, containers included, parsed by a loop over an explicit stack of open containers.
+    // Stack usage doesn't depend on the input, the nesting is bounded by maxDepth.
+    //
+    template <unsigned parseFlags = kParseDefault, typename ReadStream, typename Handler>
+    static ParseError parseValue(ReadStream& is, Handler& handler, size_t maxDepth) {
+        enum State { kValue, kAfterValue, kKey };
+
+        NestingStack stack;
+        std::string buffer;//解码字符串用, 整个解析过程中复用
+        State state = kValue;
+        while (true) {
+            switch (state) {
+                case kValue:
+                    if (!is.hasNext()) {
+                        return PARSE_EXPECT_VALUE;//没有可解析的json
                     }
-                    return;
-                case '\x01'...'\x1f'://小于0x20
-                    throw Exception(PARSE_BAD_STRING_CHAR);
-                case '\\'://转义符
-                    switch (is.next()) {
-                        case '"':  buffer.push_back('"');  break;
-                        case '\\': buffer.push_back('\\'); break;
-                        case '/':  buffer.push_back('/');  break;
-                        case 'b':  buffer.push_back('\b'); break;
-                        case 'f':  buffer.push_back('\f'); break;
-                        case 'n':  buffer.push_back('\n'); break;
-                        case 'r':  buffer.push_back('\r'); break;
-                        case 't':  buffer.push_back('\t'); break;
-                        case 'u': {
-                            // unicode stuff from Milo's tutorial
-                            unsigned u = parseHex4(is);
-                            if (u >= 0xD800 && u <= 0xDBFF) {
-                                if (is.next() != '\\')
-                                    throw Exception(PARSE_BAD_UNICODE_SURROGATE);
-                                if (is.next() != 'u')
-                                    throw Exception(PARSE_BAD_UNICODE_SURROGATE);
-                                unsigned u2 = parseHex4(is);
-                                if (u2 >= 0xDC00 && u2 <= 0xDFFF)
-                                    u = 0x10000 + (u - 0xD800) * 0x400 + (u2 - 0xDC00);
-                                else
-                                    throw Exception(PARSE_BAD_UNICODE_SURROGATE);
+                    switch (is.peek()) {
+                        case '[':
+                            if (stack.depth() == maxDepth) {
+                                return PARSE_DEPTH_EXCEEDED;
+                            }
+                            CALL(handler.StartArray());
+                            is.next();
+                            parseWhiteSpace<parseFlags>(is);
+                            if (is.peek() == ']') {
+                                is.next();
+                                CALL(handler.EndArray());
+                                state = kAfterValue;
+                            } else {
+                                stack.push(false);
                             }
-                            encodeUtf8(buffer, u);
                             break;
+                        case '{':
+                            if (stack.depth() == maxDepth) {
+                                return PARSE_DEPTH_EXCEEDED;
+                            }
+                            CALL(handler.StartObject());
+                            is.next();
+                            parseWhiteSpace<parseFlags>(is);
+                            if (is.peek() == '}') {
+                                is.next();
+                                CALL(handler.EndObject());
+                                state = kAfterValue;
+                            } else {
+                                stack.push(true);
+                                state = kKey;
+                            }
+                            break;
+                        default:
+                            CHECK_PARSE(parseScalar<parseFlags>(is, handler, buffer));
+                            state = kAfterValue;
+                            break;
+                    }
+                    break;
+
+                case kAfterValue:
+                    if (stack.depth() == 0) {
+                        return PARSE_OK;
+                    }
+                    parseWhiteSpace<parseFlags>(is);
+                    if (!stack.top()) {
+                        switch (is.peek()) {//出错时停在出错的字符上
+                            case ',':
+                                is.next();
+                                parseWhiteSpace<parseFlags>(is);
+                                if ((parseFlags & kParseTrailingCommas) && is.peek() == ']') {
+                                    break;//下一轮结束数组
+                                }
+                                state = kValue;
+                                break;
+                            case ']':
+                                is.next();
+                                stack.pop();
+                                CALL(handler.EndArray());
+                                break;
+                            default:
+                                return PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+                        }
+                    } else {
+                        switch (is.peek()) {
+                            case ',':
+                                is.next();
+                                parseWhiteSpace<parseFlags>(is);
+                                if ((parseFlags & kParseTrailingCommas) && is.peek() == '}') {
+                                    break;//下一轮结束对象
+                                }
+                                state = kKey;
+                                break;
+                            case '}':
+                                is.next();
+                                stack.pop();
+                                CALL(handler.EndObject());
+                                break;
+                            default:
+                                return PARSE_MISS_COMMA_OR_CURLY_BRACKET;
                         }
-                        default: throw Exception(PARSE_BAD_STRING_ESCAPE);
                     }
                     break;
-                default: buffer.push_back(ch);//普通字符
-            }
-        }
-        throw Exception(PARSE_MISS_QUOTATION_MARK);
-    }
 
-    template <typename ReadStream, typename Handler>
-    static void parseArray(ReadStream& is, Handler& handler) {
-        CALL(handler.StartArray());
-        
-        is.assertNext('[');
-        parseWhiteSpace(is);
+                case kKey:
+                    if (is.peek() != '"') {
+                        return PARSE_MISS_KEY;
+                    }
+                    CHECK_PARSE(parseString<parseFlags>(is, handler, true, buffer));//解析key值
 
-        if (is.peek() == ']') {
-            is.next();
-            CALL(handler.EndArray());
-            return;
+                    // parse ':'
+                    parseWhiteSpace<parseFlags>(is);
+                    if (is.peek() != ':') {
+                        return PARSE_MISS_COLON;
+                    }
+                    is.next();
+                    parseWhiteSpace<parseFlags>(is);
+                    state = kValue;
+                    break;
+            }
         }
+    }
 
+    //
+    // 快速跳过: moves past one value without producing events, strings aren't unescaped and numbers aren't converted.
+    // Only the structure is checked (quotes, matching brackets), the skipped text may still hold bad escapes or numbers.
+    //
+    template <typename ReadStream>
+    static void skipValue(ReadStream& is) {
+        static_assert(IsContiguousStream<ReadStream>::value, "skipValue() needs a contiguous stream");
+        bool more = IsRefillableStream<ReadStream>::value;
+        const char* p = is.getPtr();
+        const char* end = is.getEnd();
+        NestingStack stack;
         while (true) {
-            parseValue(is, handler);
-            parseWhiteSpace(is);
-            switch (is.next()) {
-                case ',':
-                    parseWhiteSpace(is);
+            if (p == end) {
+                if (!more) {
+                    throw Exception(stack.depth() == 0 ? PARSE_EXPECT_VALUE :
+                                    stack.top() ? PARSE_MISS_COMMA_OR_CURLY_BRACKET : PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+                }
+                more = refillAt(is, p, end);
+                continue;
+            }
+            switch (*p) {
+                case '"': {
+                    const char* q = skipString(p + 1, end);
+                    if (q == nullptr) {//字符串被窗口截断, 从引号处重新扫描
+                        if (!more) {
+                            throw Exception(PARSE_MISS_QUOTATION_MARK);
+                        }
+                        more = refillAt(is, p, end);
+                        continue;
+                    }
+                    p = q;
+                    break;
+                }
+                case '[':
+                case '{':
+                    stack.push(*p == '{');
+                    p++;
                     break;
                 case ']':
-                    CALL(handler.EndArray());
-                    return;
+                case '}':
+                    if (stack.depth() == 0) {
+                        throw Exception(PARSE_BAD_VALUE);
+                    }
+                    if (stack.top() != (*p == '}')) {
+                        throw Exception(stack.top() ? PARSE_MISS_COMMA_OR_CURLY_BRACKET : PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+                    }
+                    stack.pop();
+                    p++;
+                    break;
                 default:
-                    throw Exception(PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+                    if (stack.depth() == 0) {//标量: up to the next delimiter
+                        const char* q = p;
+                        while (q != end && !isDelimiter(*q)) {
+                            q++;
+                        }
+                        if (q == end && more) {
+                            more = refillAt(is, p, end);
+                            continue;
+                        }
+                        if (q == p) {
+                            throw Exception(PARSE_BAD_VALUE);
+                        }
+                        p = q;
+                    } else {//容器内: up to the next quotation mark or bracket
+                        p++;
+                        while (p != end && *p != '"' && *p != '[' && *p != ']' && *p != '{' && *p != '}') {
+                            p++;
+                        }
+                    }
+                    break;
+            }
+            if (stack.depth() == 0) {
+                break;
             }
         }
+        is.setPtr(p);
     }
 
-    template <typename ReadStream, typename Handler>
-    static void parseObject(ReadStream& is, Handler& handler) {
-        CALL(handler.StartObject());
-        is.assertNext('{');
-        parseWhiteSpace(is);
-        if (is.peek() == '}') {
-            is.next();
-            CALL(handler.EndObject());
-            return;
+    // p is after the opening quotation mark, returns the position after the closing one, nullptr if end comes first
+    static const char* skipString(const char* p, const char* end) {
+        while (true) {
+            p = scanString(p, end);
+            if (p == end) {
+                return nullptr;
+            }
+            switch (*p) {
+                case '"':
+                    return p + 1;
+                case '\\':
+                    if (end - p < 2) {
+                        return nullptr;
+                    }
+                    p += 2;
+                    break;
+                default:
+                    throw Exception(PARSE_BAD_STRING_CHAR);
+            }
         }
+    }
 
+    // the string at the read position is brought into the window as a whole,
+    // returns the position after its closing quotation mark and leaves the read position on the opening one
+    template <typename ReadStream>
+    static const char* scanStringToken(ReadStream& is) {
+        bool more = IsRefillableStream<ReadStream>::value;
         while (true) {
-            if (is.peek() != '"') {
-                throw Exception(PARSE_MISS_KEY);
+            const char* q = skipString(is.getPtr() + 1, is.getEnd());
+            if (q != nullptr) {
+                return q;
             }
-            parseString(is, handler, true);//解析key值
-
-            // parse ':'
-            parseWhiteSpace(is);
-            if (is.next() != ':') {
-                throw Exception(PARSE_MISS_COLON);
+            if (!more) {
+                throw Exception(PARSE_MISS_QUOTATION_MARK);
             }
-            parseWhiteSpace(is);
+            more = refill(is);
+        }
+    }
 
-            // go on
-            parseValue(is, handler);
-            parseWhiteSpace(is);
-            switch (is.next()) {
-                case ',':
-                    parseWhiteSpace(is);
-                    break;
-                case '}':
-                    CALL(handler.EndObject());
-                    return;
-                default:
-                    throw Exception(PARSE_MISS_COMMA_OR_CURLY_BRACKET);
+    // refills from p on, p and end follow the window
+    template <typename ReadStream>
+    static bool refillAt(ReadStream& is, const char*& p, const char*& end) {
+        is.setPtr(p);
+        bool more = refill(is);
+        p = is.getPtr();
+        end = is.getEnd();
+        return more;
+    }
+
+    // one bit per open container (1 = object), the first 256 levels don't allocate
+    class NestingStack {
+    public:
+        size_t depth() const { return m_depth; }
+
+        bool top() const { return get(m_depth - 1); }
+
+        void push(bool isObject) {
+            size_t word = m_depth / 64;
+            if (word >= kInlineWords && word - kInlineWords >= m_heap.size()) {
+                m_heap.push_back(0);
             }
+            uint64_t& w = word < kInlineWords ? m_inline[word] : m_heap[word - kInlineWords];
+            uint64_t bit = uint64_t(1) << (m_depth % 64);
+            w = isObject ? (w | bit) : (w & ~bit);
+            m_depth++;
         }
-    }
+
+        void pop() {
+            assert(m_depth > 0);
+            m_depth--;
+        }
+
+    private:
+        enum { kInlineWords = 4 };
+
+        bool get(size_t i) const {
+            size_t word = i / 64;
+            uint64_t w = word < kInlineWords ? m_inline[word] : m_heap[word - kInlineWords];
+            return (w >> (i % 64)) & 1;
+        }
+
+        uint64_t m_inline[kInlineWords];
+        std::vector<uint64_t> m_heap;
+        size_t m_depth = 0;
+    };
+
 #undef CALL
+#undef CHECK_PARSE
 
 public:
     static bool isDigit(char ch) { return ch >= '0' && ch <= '9'; }
     static bool isDigit19(char ch) { return ch >= '1' && ch <= '9'; }
+    // numbers and literals run up to whitespace or a structural character
+    static bool isDelimiter(char ch) {
+        switch (ch) {
+            case ' ': case '\t': case '\r': case '\n':
+            case ',': case ':': case '[': case ']': case '{': case '}': case '"':
+                return true;
+            default:
+                return false;
+        }
+    }
 private:
-    static void encodeUtf8(std::string& buffer, unsigned u);
+    static unsigned encodeUtf8(char* buf, unsigned u);//返回写入buf的字节数
+    static void locateLine(const char* begin, const char* p, ParseResult& result);//p所在的行和列
+    static bool isValidUtf8(const char* s, size_t len);
+    static void putChar(std::string& buffer, char ch) { buffer.push_back(ch); }
+    static void putChar(InsituStringStream& is, char ch) { is.put(ch); }
+    static void putRun(std::string& buffer, const char* s, size_t len) { buffer.append(s, len); }
+    static void putRun(InsituStringStream& is, const char* s, size_t len) { is.put(s, len); }
     template <typename ReadStream>
-    static unsigned parseHex4(ReadStream& is) {
+    static ParseError parseHex4(ReadStream& is, unsigned& u) {
         // unicode stuff from Milo's tutorial
-        unsigned u = 0;
+        u = 0;
         for (int i = 0; i < 4; i++) {
             u <<= 4;
             switch (char ch = is.next()) {
                 case '0'...'9': u |= ch - '0'; break;
                 case 'a'...'f': u |= ch - 'a' + 10; break;
                 case 'A'...'F': u |= ch - 'A' + 10; break;
-                default: throw Exception(PARSE_BAD_UNICODE_HEX);
+                default: return PARSE_BAD_UNICODE_HEX;
             }
         }
-        return u;
+        return PARSE_OK;
     }
     
 };
@@ -0,0 +1,405 @@
+#include "Simd.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPPJSON_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace cppjson {
+
+static bool isWhiteSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+static const char* skipWhiteSpaceScalar(const char* p, const char* end) {
+    while (p != end && isWhiteSpace(*p)) {
+        p++;
+    }
+    return p;
+}
+
+static bool isStringSpecial(char ch) {
+    return ch == '"' || ch == '\\' || static_cast<unsigned char>(ch) < 0x20;
+}
+
+static const char* scanStringScalar(const char* p, const char* end) {
+    while (p != end && !isStringSpecial(*p)) {
+        p++;
+    }
+    return p;
+}
+
+// bit i of each mask describes byte i of a 64-byte block
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t whiteSpace;
+    uint64_t op;//{ } [ ] : ,
+    uint64_t control;//< 0x20
+};
+
+// turns the character masks of consecutive blocks into index entries, state is carried between blocks
+class StructuralIndexer {
+public:
+    StructuralIndexer(StructuralIndexState& state, uint32_t* index) : m_state(state), m_out(index) {}
+
+    bool inString() const { return m_state.m_inString != 0; }
+
+    // a block inside a string without quotes, backslashes or control characters has nothing to index
+    void plainStringBlock() {
+        m_state.m_escaped = 0;
+    }
+
+    __attribute__((always_inline)) void block(const BlockMasks& m, uint32_t offset) {
+        // a character is escaped if it follows an odd run of backslashes, runs are rare so walk them
+        uint64_t escaped = m_state.m_escaped;
+        m_state.m_escaped = 0;
+        uint64_t backslash = m.backslash & ~escaped;
+        while (backslash != 0) {
+            int i = __builtin_ctzll(backslash);
+            if (i == 63) {
+                m_state.m_escaped = 1;
+            } else {
+                escaped |= 1ULL << (i + 1);
+                backslash &= ~(1ULL << (i + 1));
+            }
+            backslash &= backslash - 1;
+        }
+
+        // prefix xor: bits from an opening quote up to (not including) its closing quote
+        uint64_t quote = m.quote & ~escaped;
+        uint64_t inString = quote;
+        inString ^= inString << 1;
+        inString ^= inString << 2;
+        inString ^= inString << 4;
+        inString ^= inString << 8;
+        inString ^= inString << 16;
+        inString ^= inString << 32;
+        inString ^= m_state.m_inString;
+        m_state.m_inString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+        uint64_t op = m.op & ~inString;
+        uint64_t scalar = ~(m.op | m.whiteSpace | quote) & ~inString;
+        uint64_t scalarStart = scalar & ~((scalar << 1) | m_state.m_scalar);
+        m_state.m_scalar = scalar >> 63;
+        uint64_t special = ((m.backslash & ~escaped) | m.control) & inString;//字符串里要解码或报错的字符
+
+        flatten(op | scalarStart | quote | special, offset);
+    }
+
+    uint32_t* end() const { return m_out; }
+
+private:
+    // every entry is a different byte of the chunk, so the index has room for them
+    __attribute__((always_inline)) void flatten(uint64_t bits, uint32_t offset) {
+        while (bits != 0) {
+            *m_out++ = offset + __builtin_ctzll(bits);
+            bits &= bits - 1;
+        }
+    }
+
+    StructuralIndexState& m_state;
+    uint32_t* m_out;
+};
+
+static BlockMasks classifyScalar(const char* p) {
+    BlockMasks m = {0, 0, 0, 0, 0};
+    for (int i = 0; i < 64; i++) {
+        uint64_t bit = 1ULL << i;
+        if (static_cast<unsigned char>(p[i]) < 0x20) {
+            m.control |= bit;
+        }
+        switch (p[i]) {
+            case '"': m.quote |= bit; break;
+            case '\\': m.backslash |= bit; break;
+            case ' ': case '\t': case '\r': case '\n': m.whiteSpace |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': m.op |= bit; break;
+            default: break;
+        }
+    }
+    return m;
+}
+
+// the last len % 64 bytes, padded with blanks to a whole block
+struct TailBlock {
+    TailBlock(const char* p, size_t len) {
+        memset(m_bytes, ' ', sizeof(m_bytes));
+        memcpy(m_bytes, p, len);
+    }
+    char m_bytes[64];
+};
+
+// one loop per instruction set, compiled with it: classify and StructuralIndexer are inlined into the loop
+static size_t buildIndexScalar(const char* json, size_t offset, size_t len, StructuralIndexState& state, uint32_t* index) {
+    StructuralIndexer indexer(state, index);
+    size_t end = offset + len;
+    for (; offset + 64 <= end; offset += 64) {
+        indexer.block(classifyScalar(json + offset), static_cast<uint32_t>(offset));
+    }
+    if (offset < end) {
+        TailBlock tail(json + offset, end - offset);
+        indexer.block(classifyScalar(tail.m_bytes), static_cast<uint32_t>(offset));
+    }
+    return indexer.end() - index;
+}
+
+#ifdef CPPJSON_SIMD_X86
+
+__attribute__((target("sse2")))
+static const char* skipWhiteSpaceSse2(const char* p, const char* end) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, space), _mm_cmpeq_epi8(x, tab)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(x, cr), _mm_cmpeq_epi8(x, lf)));
+        unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(ws)) & 0xFFFF;
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return skipWhiteSpaceScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* skipWhiteSpaceAvx2(const char* p, const char* end) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    for (; end - p >= 32; p += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, space), _mm256_cmpeq_epi8(x, tab)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(x, cr), _mm256_cmpeq_epi8(x, lf)));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(ws));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return skipWhiteSpaceSse2(p, end);//不足32字节的尾部
+}
+
+__attribute__((target("sse2")))
+static const char* scanStringSse2(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // x <= 0x1F (unsigned) <=> max(x, 0x1F) == 0x1F
+        __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)),
+                                       _mm_cmpeq_epi8(_mm_max_epu8(x, control), control));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return scanStringScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* scanStringAvx2(const char* p, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    for (; end - p >= 32; p += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, backslash)),
+                                          _mm256_cmpeq_epi8(_mm256_max_epu8(x, control), control));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return scanStringSse2(p, end);
+}
+
+// '"', '\\' or a control character in the 64 bytes at p
+__attribute__((target("sse2"), always_inline))
+static inline bool hasStringSpecialSse2(const char* p) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    __m128i special = _mm_setzero_si128();
+    for (int i = 0; i < 4; i++) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+        special = _mm_or_si128(special, _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)),
+                                                     _mm_cmpeq_epi8(_mm_max_epu8(x, control), control)));
+    }
+    return _mm_movemask_epi8(special) != 0;
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline bool hasStringSpecialAvx2(const char* p) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    __m256i special = _mm256_setzero_si256();
+    for (int i = 0; i < 2; i++) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i));
+        special = _mm256_or_si256(special, _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, backslash)),
+                                                           _mm256_cmpeq_epi8(_mm256_max_epu8(x, control), control)));
+    }
+    return !_mm256_testz_si256(special, special);
+}
+
+__attribute__((target("sse2"), always_inline))
+static inline BlockMasks classifySse2(const char* p) {
+    const __m128i control = _mm_set1_epi8(0x1F);
+    BlockMasks m = {0, 0, 0, 0, 0};
+    for (int i = 0; i < 4; i++) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+        auto is = [x](char ch) { return _mm_cmpeq_epi8(x, _mm_set1_epi8(ch)); };
+        auto bits = [i](__m128i v) { return static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(v))) << (16 * i); };
+        m.quote |= bits(is('"'));
+        m.backslash |= bits(is('\\'));
+        m.whiteSpace |= bits(_mm_or_si128(_mm_or_si128(is(' '), is('\t')), _mm_or_si128(is('\r'), is('\n'))));
+        m.op |= bits(_mm_or_si128(_mm_or_si128(_mm_or_si128(is('{'), is('}')), _mm_or_si128(is('['), is(']'))),
+                                  _mm_or_si128(is(':'), is(','))));
+        m.control |= bits(_mm_cmpeq_epi8(_mm_max_epu8(x, control), control));
+    }
+    return m;
+}
+
+//
+// whitespace and operators are looked up by the low nibble with pshufb, see:
+//     Geoff Langdale, Daniel Lemire, "Parsing Gigabytes of JSON per Second", https://arxiv.org/abs/1902.08318
+// '[' and ']' differ from '{' and '}' by 0x20 only, so for those two nibbles x | 0x20 is compared to the operator table.
+// Only those two: with ':' and ',' the 0x20 would turn 0x1A and 0x0C into operators.
+// The unused entries are 0x80, which no byte below 0x80 equals (pshufb gives 0 for the bytes above).
+//
+__attribute__((target("avx2"), always_inline))
+static inline BlockMasks classifyAvx2(const char* p) {
+    const __m256i whiteSpaceTable = _mm256_setr_epi8(
+        ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r', 100, 100,
+        ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r', 100, 100);
+    const char x80 = static_cast<char>(0x80);
+    const __m256i opTable = _mm256_setr_epi8(
+        x80, x80, x80, x80, x80, x80, x80, x80, x80, x80, ':', '{', ',', '}', x80, x80,
+        x80, x80, x80, x80, x80, x80, x80, x80, x80, x80, ':', '{', ',', '}', x80, x80);
+    const __m256i curlyTable = _mm256_setr_epi8(
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x20, 0, 0x20, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x20, 0, 0x20, 0, 0);
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+
+    BlockMasks m = {0, 0, 0, 0, 0};
+    for (int i = 0; i < 2; i++) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i));
+        __m256i whiteSpace = _mm256_cmpeq_epi8(_mm256_shuffle_epi8(whiteSpaceTable, x), x);
+        __m256i curly = _mm256_or_si256(x, _mm256_shuffle_epi8(curlyTable, x));
+        __m256i op = _mm256_cmpeq_epi8(_mm256_shuffle_epi8(opTable, x), curly);
+        __m256i controlChar = _mm256_cmpeq_epi8(_mm256_max_epu8(x, control), control);
+        int shift = 32 * i;
+        m.quote |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, quote)))) << shift;
+        m.backslash |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, backslash)))) << shift;
+        m.whiteSpace |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(whiteSpace))) << shift;
+        m.op |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(op))) << shift;
+        m.control |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(controlChar))) << shift;
+    }
+    return m;
+}
+
+__attribute__((target("sse2")))
+static size_t buildIndexSse2(const char* json, size_t offset, size_t len, StructuralIndexState& state, uint32_t* index) {
+    StructuralIndexer indexer(state, index);
+    size_t end = offset + len;
+    for (; offset + 64 <= end; offset += 64) {
+        if (indexer.inString() && !hasStringSpecialSse2(json + offset)) {//long strings go at the speed of scanString()
+            indexer.plainStringBlock();
+            continue;
+        }
+        indexer.block(classifySse2(json + offset), static_cast<uint32_t>(offset));
+    }
+    if (offset < end) {
+        TailBlock tail(json + offset, end - offset);
+        indexer.block(classifySse2(tail.m_bytes), static_cast<uint32_t>(offset));
+    }
+    return indexer.end() - index;
+}
+
+__attribute__((target("avx2")))
+static size_t buildIndexAvx2(const char* json, size_t offset, size_t len, StructuralIndexState& state, uint32_t* index) {
+    StructuralIndexer indexer(state, index);
+    size_t end = offset + len;
+    for (; offset + 64 <= end; offset += 64) {
+        if (indexer.inString() && !hasStringSpecialAvx2(json + offset)) {//long strings go at the speed of scanString()
+            indexer.plainStringBlock();
+            continue;
+        }
+        indexer.block(classifyAvx2(json + offset), static_cast<uint32_t>(offset));
+    }
+    if (offset < end) {
+        TailBlock tail(json + offset, end - offset);
+        indexer.block(classifyAvx2(tail.m_bytes), static_cast<uint32_t>(offset));
+    }
+    return indexer.end() - index;
+}
+
+typedef const char* (*ScanFunc)(const char*, const char*);
+
+static ScanFunc selectScanFunc(ScanFunc avx2, ScanFunc sse2, ScanFunc scalar) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return sse2;
+    }
+    return scalar;
+}
+
+typedef size_t (*IndexFunc)(const char*, size_t, size_t, StructuralIndexState&, uint32_t*);
+
+static IndexFunc selectIndexFunc() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return buildIndexAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return buildIndexSse2;
+    }
+    return buildIndexScalar;
+}
+
+#endif
+
+const char* skipWhiteSpace(const char* p, const char* end) {
+    // minified json has at most one blank between tokens, don't pay for a vector load then
+    if (p == end || !isWhiteSpace(*p)) {
+        return p;
+    }
+    if (++p == end || !isWhiteSpace(*p)) {
+        return p;
+    }
+#ifdef CPPJSON_SIMD_X86
+    static const ScanFunc impl = selectScanFunc(skipWhiteSpaceAvx2, skipWhiteSpaceSse2, skipWhiteSpaceScalar);
+    return impl(p, end);
+#else
+    return skipWhiteSpaceScalar(p, end);
+#endif
+}
+
+const char* scanString(const char* p, const char* end) {
+#ifdef CPPJSON_SIMD_X86
+    static const ScanFunc impl = selectScanFunc(scanStringAvx2, scanStringSse2, scanStringScalar);
+    return impl(p, end);
+#else
+    return scanStringScalar(p, end);
+#endif
+}
+
+size_t buildStructuralIndex(const char* json, size_t offset, size_t len, StructuralIndexState& state, uint32_t* index) {
+#ifdef CPPJSON_SIMD_X86
+    static const IndexFunc impl = selectIndexFunc();
+    return impl(json, offset, len, state, index);
+#else
+    return buildIndexScalar(json, offset, len, state, index);
+#endif
+}
+
+}
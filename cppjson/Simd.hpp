@@ -0,0 +1,34 @@
+#ifndef CPPJSON_SIMD_HPP
+#define CPPJSON_SIMD_HPP
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace cppjson {
+
+// Vectorized scanners over contiguous memory. The instruction set (AVX2, SSE2 or plain C++)
+// is picked once at runtime from what the CPU supports; every version returns the same result.
+
+// returns the first position in [p, end) that is not ' ', '\t', '\r' or '\n', or end
+const char* skipWhiteSpace(const char* p, const char* end);
+
+// returns the first '"', '\\' or control character (< 0x20) in [p, end), or end
+const char* scanString(const char* p, const char* end);
+
+// what stage 1 carries from one chunk of the input to the next, zeroed for a new input
+struct StructuralIndexState {
+    uint64_t m_escaped;//上一块以未转义的'\\'结尾
+    uint64_t m_inString;//全1: 上一块结束时在字符串内
+    uint64_t m_scalar;//上一块以标量结尾
+};
+
+// stage 1 of IndexReader, one chunk [offset, offset + len) of json at a time: offset is a multiple of 64, len too
+// except for the last chunk. Writes to index (room for len entries) the offsets, in json, in order, of:
+// the structural characters ({ } [ ] : ,), the first character of every other token outside strings,
+// the opening and closing quotes, and inside strings the unescaped backslashes and the control characters (< 0x20).
+// Returns the number of entries. offset + len must be < 4GB
+size_t buildStructuralIndex(const char* json, size_t offset, size_t len, StructuralIndexState& state, uint32_t* index);
+
+}
+
+#endif
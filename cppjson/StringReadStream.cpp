@@ -24,8 +24,31 @@ const StringReadStream::Iterator StringReadStream::getIter() {
     return m_iterator;
 }
 
+size_t StringReadStream::tell() {
+    return m_iterator - m_json.begin();
+}
+
 void StringReadStream::assertNext(char ch) {
-    assert(next() == ch);
+    char c = next();//NDEBUG下也要读取
+    assert(c == ch);
+    (void)c; (void)ch;
+}
+
+const char* StringReadStream::getPtr() {
+    return m_json.data() + (m_iterator - m_json.begin());
+}
+
+const char* StringReadStream::getEnd() {
+    return m_json.data() + m_json.size();
+}
+
+void StringReadStream::setPtr(const char* p) {
+    assert(p >= getPtr() && p <= getEnd());
+    m_iterator += p - getPtr();
+}
+
+const char* StringReadStream::getBegin() {
+    return m_json.data();
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef CPPJSON_STRINGREF_HPP
+#define CPPJSON_STRINGREF_HPP
+
+#include <cstring>
+#include <string>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace cppjson {
+
+//
+// 字符串视图: a pointer and a length, nothing is copied. Built implicitly from a literal, a const char*,
+// a std::string (or a std::string_view in C++17), so the lookups taking a StringRef accept all of them
+// without building a std::string. The bytes must outlive the StringRef.
+//
+class StringRef {
+public:
+    StringRef(const char* s) : m_s(s), m_length(strlen(s)) {}
+    StringRef(const char* s, size_t len) : m_s(s), m_length(len) {}
+    StringRef(const std::string& s) : m_s(s.data()), m_length(s.size()) {}
+#if __cplusplus >= 201703L
+    StringRef(std::string_view s) : m_s(s.data()), m_length(s.size()) {}
+    operator std::string_view() const { return std::string_view(m_s, m_length); }
+#endif
+
+    const char* data() const { return m_s; }
+    size_t size() const { return m_length; }
+    bool empty() const { return m_length == 0; }
+
+    std::string str() const { return std::string(m_s, m_length); }
+
+    bool operator==(StringRef rhs) const { return m_length == rhs.m_length && memcmp(m_s, rhs.m_s, m_length) == 0; }
+    bool operator!=(StringRef rhs) const { return !(*this == rhs); }
+
+private:
+    const char* m_s;
+    size_t m_length;
+};
+
+}
+
+#endif
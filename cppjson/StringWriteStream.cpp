@@ -9,6 +9,10 @@ void StringWriteStream::put(std::string s) {
     m_buffer.insert(m_buffer.end(), s.begin(), s.end());
 }
 
+void StringWriteStream::put(const char* s, size_t len) {
+    m_buffer.insert(m_buffer.end(), s, s + len);
+}
+
 std::string StringWriteStream::get() {
     return std::string(&*m_buffer.begin(), m_buffer.size());
 }
@@ -14,6 +14,7 @@ private:
 public:
     void put(char ch);
     void put(std::string s);
+    void put(const char* s, size_t len);
     std::string get();
 };
 
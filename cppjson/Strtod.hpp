@@ -0,0 +1,19 @@
+#ifndef CPPJSON_STRTOD_HPP
+#define CPPJSON_STRTOD_HPP
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace cppjson {
+
+// significand * 10^exponent correctly rounded to a double, significand holds the first 19 significant
+// digits and truncated tells whether non-zero digits were dropped after them.
+// Returns false when the result can't be decided that way, use slowStrtod() on the text then.
+bool fastStrtod(uint64_t significand, int64_t exponent, bool negative, bool truncated, double* d);
+
+// strtod in the "C" locale, text needn't be null terminated
+double slowStrtod(const char* text, size_t len);
+
+}
+
+#endif
@@ -0,0 +1,262 @@
+#include "TapeDocument.hpp"
+#include "MemoryReadStream.hpp"
+
+namespace cppjson {
+
+ValueType TapeValue::getType() const {
+    switch (tag()) {
+        case 'n': return TYPE_NULL;
+        case 't':
+        case 'f': return TYPE_BOOL;
+        case 'i': return TYPE_INT32;
+        case 'l': return TYPE_INT64;
+        case 'd': return TYPE_DOUBLE;
+        case 's': return TYPE_STRING;
+        case '[': return TYPE_ARRAY;
+        case '{': return TYPE_OBJECT;
+    }
+    assert(false && "bad tape word");
+    return TYPE_NULL;
+}
+
+uint32_t TapeValue::after() const {
+    switch (tag()) {
+        case 'l':
+        case 'd':
+            return m_index + 2;
+        case '[':
+        case '{':
+            return static_cast<uint32_t>(word());
+    }
+    return m_index + 1;
+}
+
+size_t TapeValue::getSize() const {
+    assert(tag() == '[' || tag() == '{');
+    size_t count = static_cast<size_t>((word() >> 32) & TapeDocument::kMaxCount);
+    if (count < TapeDocument::kMaxCount) {
+        return count;
+    }
+    //计数饱和, 逐个数
+    count = 0;
+    if (tag() == '[') {
+        for (auto it = getArray().begin(), end = getArray().end(); it != end; ++it) {
+            count++;
+        }
+    } else {
+        for (auto it = getObject().begin(), end = getObject().end(); it != end; ++it) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool TapeValue::getBool() const {
+    assert(tag() == 't' || tag() == 'f');
+    return tag() == 't';
+}
+
+int32_t TapeValue::getInt32() const {
+    assert(tag() == 'i');
+    return static_cast<int32_t>(static_cast<uint32_t>(word()));
+}
+
+int64_t TapeValue::getInt64() const {
+    assert(tag() == 'i' || tag() == 'l');
+    if (tag() == 'i') {
+        return getInt32();
+    }
+    return static_cast<int64_t>(m_doc->m_tape[m_index + 1]);
+}
+
+double TapeValue::getDouble() const {
+    assert(tag() == 'd');
+    double d;
+    uint64_t bits = m_doc->m_tape[m_index + 1];
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+const char* TapeValue::getStringData() const {
+    assert(tag() == 's');
+    return m_doc->m_strings.data() + (word() & TapeDocument::kPayloadMask) + sizeof(uint32_t);
+}
+
+size_t TapeValue::getStringLength() const {
+    assert(tag() == 's');
+    uint32_t len;
+    memcpy(&len, m_doc->m_strings.data() + (word() & TapeDocument::kPayloadMask), sizeof(len));
+    return len;
+}
+
+std::string TapeValue::getString() const {
+    return std::string(getStringData(), getStringLength());
+}
+
+TapeArray TapeValue::getArray() const {
+    assert(tag() == '[');
+    return TapeArray(TapeArrayIterator(m_doc, m_index + 1), TapeArrayIterator(m_doc, after() - 1));
+}
+
+TapeObject TapeValue::getObject() const {
+    assert(tag() == '{');
+    return TapeObject(TapeMemberIterator(m_doc, m_index + 1), TapeMemberIterator(m_doc, after() - 1));
+}
+
+TapeValue TapeValue::operator[] (size_t i) const {
+    assert(tag() == '[');
+    auto it = getArray().begin();
+    for (; i > 0; i--) {
+        assert(it != getArray().end());
+        ++it;
+    }
+    assert(it != getArray().end());
+    return *it;
+}
+
+TapeValue TapeValue::operator[] (StringRef key) const {
+    auto it = findMember(key);
+    assert(it != getObject().end());
+    return it->m_value;
+}
+
+TapeMemberIterator TapeValue::findMember(const char* key, size_t len) const {
+    TapeObject object = getObject();
+    auto it = object.begin();
+    for (; it != object.end(); ++it) {
+        const TapeValue& k = it->m_key;
+        if (k.getStringLength() == len && memcmp(k.getStringData(), key, len) == 0) {
+            break;
+        }
+    }
+    return it;
+}
+
+TapeMemberIterator TapeValue::findMember(StringRef key) const {
+    return findMember(key.data(), key.size());
+}
+
+void TapeDocument::clear() {
+    m_tape.clear();
+    m_strings.clear();
+    m_stack.clear();
+}
+
+void TapeDocument::countElement(char container) {
+    if (!m_stack.empty()) {
+        uint64_t& open = m_tape[m_stack.back()];
+        if (static_cast<char>(open >> 56) == container && ((open >> 32) & kMaxCount) < kMaxCount) {
+            open += uint64_t(1) << 32;
+        }
+    }
+}
+
+void TapeDocument::addWord(char tag, uint64_t payload) {
+    countElement('[');//数组在这里计数, 对象在Key()里计数
+    m_tape.push_back(makeWord(tag, payload));
+}
+
+void TapeDocument::addString(const char* s, size_t len) {
+    if (len > std::numeric_limits<uint32_t>::max() || m_strings.size() + len + 5 > kPayloadMask) {
+        throw Exception(PARSE_DOCUMENT_TOO_LARGE);
+    }
+    countElement('[');
+    uint32_t len32 = static_cast<uint32_t>(len);
+    size_t offset = m_strings.size();
+    m_strings.resize(offset + sizeof(len32) + len + 1);
+    char* p = &m_strings[offset];
+    memcpy(p, &len32, sizeof(len32));
+    memcpy(p + sizeof(len32), s, len);
+    p[sizeof(len32) + len] = '\0';
+    m_tape.push_back(makeWord('s', offset));
+}
+
+void TapeDocument::startContainer(char tag) {
+    if (m_tape.size() >= std::numeric_limits<uint32_t>::max() - 2) {
+        throw Exception(PARSE_DOCUMENT_TOO_LARGE);
+    }
+    addWord(tag, 0);
+    m_stack.push_back(static_cast<uint32_t>(m_tape.size() - 1));
+}
+
+void TapeDocument::endContainer(char tag) {
+    assert(!m_stack.empty());
+    uint32_t open = m_stack.back();
+    m_stack.pop_back();
+    m_tape.push_back(makeWord(tag, open));
+    if (m_tape.size() > std::numeric_limits<uint32_t>::max()) {
+        throw Exception(PARSE_DOCUMENT_TOO_LARGE);
+    }
+    m_tape[open] |= static_cast<uint32_t>(m_tape.size());
+}
+
+bool TapeDocument::Null() {
+    addWord('n', 0);
+    return true;
+}
+
+bool TapeDocument::Bool(bool b) {
+    addWord(b ? 't' : 'f', 0);
+    return true;
+}
+
+bool TapeDocument::Int32(int32_t i32) {
+    addWord('i', static_cast<uint32_t>(i32));
+    return true;
+}
+
+bool TapeDocument::Int64(int64_t i64) {
+    addWord('l', 0);
+    m_tape.push_back(static_cast<uint64_t>(i64));
+    return true;
+}
+
+bool TapeDocument::Double(double d) {
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    addWord('d', 0);
+    m_tape.push_back(bits);
+    return true;
+}
+
+bool TapeDocument::String(const char* s, size_t len, bool) {
+    addString(s, len);
+    return true;
+}
+
+bool TapeDocument::StartArray() {
+    startContainer('[');
+    return true;
+}
+
+bool TapeDocument::EndArray() {
+    endContainer(']');
+    return true;
+}
+
+bool TapeDocument::Key(const char* s, size_t len, bool) {
+    countElement('{');
+    addString(s, len);
+    return true;
+}
+
+bool TapeDocument::StartObject() {
+    startContainer('{');
+    return true;
+}
+
+bool TapeDocument::EndObject() {
+    endContainer('}');
+    return true;
+}
+
+ParseError TapeDocument::parse(const char* json, size_t len) {
+    MemoryReadStream is(json, len);
+    return parseStream(is);
+}
+
+ParseError TapeDocument::parse(const std::string& json) {
+    return parse(json.data(), json.size());
+}
+
+}
@@ -0,0 +1,261 @@
+#ifndef CPPJSON_TAPEDOCUMENT_HPP
+#define CPPJSON_TAPEDOCUMENT_HPP
+
+#include <cassert>
+#include <string>
+#include <vector>
+#include "Reader.hpp"
+#include "StringRef.hpp"
+
+namespace cppjson {
+
+class TapeDocument;
+class TapeArrayIterator;
+class TapeMemberIterator;
+class TapeArray;
+class TapeObject;
+
+//
+// TapeValue: 只读游标, a (document, tape index) pair, cheap to copy.
+// It stays valid as long as the TapeDocument is alive and not re-parsed.
+//
+class TapeValue {
+    friend class TapeDocument;
+    friend class TapeArrayIterator;
+    friend class TapeMemberIterator;
+public:
+    TapeValue() : m_doc(nullptr), m_index(0) {}
+
+    ValueType getType() const;
+    size_t getSize() const;//元素(成员)个数
+
+    bool isNull() const{ return getType() == TYPE_NULL; }
+    bool isBool() const{ return getType() == TYPE_BOOL; }
+    bool isInt32() const{ return getType() == TYPE_INT32; }
+    bool isInt64() const{ return getType() == TYPE_INT64 || getType() == TYPE_INT32; }
+    bool isDouble() const{ return getType() == TYPE_DOUBLE; }
+    bool isString() const{ return getType() == TYPE_STRING; }
+    bool isArray()  const{ return getType() == TYPE_ARRAY; }
+    bool isObject() const{ return getType() == TYPE_OBJECT; }
+
+    bool getBool() const;
+    int32_t getInt32() const;
+    int64_t getInt64() const;
+    double getDouble() const;
+    std::string getString() const;
+    const char* getStringData() const;//指向字符串区, 以'\0'结尾
+    size_t getStringLength() const;
+
+    TapeArray getArray() const;
+    TapeObject getObject() const;
+
+    TapeValue operator[] (StringRef key) const;
+    TapeValue operator[] (size_t i) const;
+
+    TapeMemberIterator findMember(const char* key, size_t len) const;
+    TapeMemberIterator findMember(StringRef key) const;
+
+    // 重新生成事件流, e.g. accept(writer) serializes the value
+    template <typename Handler>
+    bool accept(Handler& handler) const;
+
+private:
+    TapeValue(const TapeDocument* doc, uint32_t index) : m_doc(doc), m_index(index) {}
+
+    uint64_t word() const;
+    char tag() const;
+    uint32_t after() const;//下一个兄弟节点在tape中的位置
+
+    const TapeDocument* m_doc;
+    uint32_t m_index;
+};
+
+struct TapeMember {
+    TapeValue m_key;
+    TapeValue m_value;
+};
+
+class TapeArrayIterator {
+public:
+    TapeArrayIterator(const TapeDocument* doc, uint32_t index) : m_value(doc, index) {}
+
+    const TapeValue& operator*() const { return m_value; }
+    const TapeValue* operator->() const { return &m_value; }
+    TapeArrayIterator& operator++() {
+        m_value.m_index = m_value.after();
+        return *this;
+    }
+    bool operator==(const TapeArrayIterator& rhs) const { return m_value.m_index == rhs.m_value.m_index; }
+    bool operator!=(const TapeArrayIterator& rhs) const { return m_value.m_index != rhs.m_value.m_index; }
+
+private:
+    TapeValue m_value;
+};
+
+class TapeMemberIterator {
+public:
+    TapeMemberIterator(const TapeDocument* doc, uint32_t index) {
+        m_member.m_key = TapeValue(doc, index);
+        m_member.m_value = TapeValue(doc, index + 1);
+    }
+
+    const TapeMember& operator*() const { return m_member; }
+    const TapeMember* operator->() const { return &m_member; }
+    TapeMemberIterator& operator++() {
+        m_member.m_key.m_index = m_member.m_value.after();
+        m_member.m_value.m_index = m_member.m_key.m_index + 1;
+        return *this;
+    }
+    bool operator==(const TapeMemberIterator& rhs) const { return m_member.m_key.m_index == rhs.m_member.m_key.m_index; }
+    bool operator!=(const TapeMemberIterator& rhs) const { return m_member.m_key.m_index != rhs.m_member.m_key.m_index; }
+
+private:
+    TapeMember m_member;
+};
+
+class TapeArray {
+public:
+    TapeArray(TapeArrayIterator begin, TapeArrayIterator end) : m_begin(begin), m_end(end) {}
+    TapeArrayIterator begin() const { return m_begin; }
+    TapeArrayIterator end() const { return m_end; }
+private:
+    TapeArrayIterator m_begin, m_end;
+};
+
+class TapeObject {
+public:
+    TapeObject(TapeMemberIterator begin, TapeMemberIterator end) : m_begin(begin), m_end(end) {}
+    TapeMemberIterator begin() const { return m_begin; }
+    TapeMemberIterator end() const { return m_end; }
+private:
+    TapeMemberIterator m_begin, m_end;
+};
+
+//
+// TapeDocument: 只读DOM, the parse result lives in two contiguous buffers instead of a tree of Values:
+//     m_tape:    one 64-bit word per token, tag in the high 8 bits and a 56-bit payload
+//     m_strings: the string arena, each string stored as a 4-byte length, the bytes and a '\0'
+//
+// tape words:
+//     'n' 't' 'f'        null, true, false
+//     'i'                int32, payload = the 32 bits of the value
+//     'l' 'd'            int64, double, the value is stored in the next word
+//     's'                string or key, payload = offset in the string arena
+//     '[' '{'            payload = tape index after the matching ']' '}' (low 32 bits)
+//                        and the element/member count (high 24 bits, saturated)
+//     ']' '}'            payload = tape index of the matching '[' '{'
+// an object holds key, value, key, value ... between its '{' and '}'
+//
+// Both buffers are kept between parses, a TapeDocument reused for a batch of documents stops allocating.
+//
+class TapeDocument : public Nocopyable {
+    friend class TapeValue;
+public:
+    ParseError parse(const char* json, size_t len);
+    ParseError parse(const std::string& json);
+
+    template <typename ReadStream>
+    ParseError parseStream(ReadStream& is) {
+        clear();
+        ParseError err = Reader::parse(is, *this);
+        if (err != PARSE_OK) {
+            clear();
+        }
+        return err;
+    }
+
+    TapeValue root() const {
+        assert(!m_tape.empty());
+        return TapeValue(this, 0);
+    }
+
+    size_t getTapeSize() const { return m_tape.size(); }
+    size_t getStringArenaSize() const { return m_strings.size(); }
+
+public:
+    bool Null();
+    bool Bool(bool b);
+    bool Int32(int32_t i32);
+    bool Int64(int64_t i64);
+    bool Double(double d);
+    bool String(const char* s, size_t len, bool copy);
+    bool StartArray();
+    bool EndArray();
+    bool Key(const char* s, size_t len, bool copy);
+    bool StartObject();
+    bool EndObject();
+
+private:
+    enum : uint64_t {
+        kPayloadMask = (uint64_t(1) << 56) - 1,
+        kMaxCount = (1 << 24) - 1,
+    };
+
+    static uint64_t makeWord(char tag, uint64_t payload) {
+        return (static_cast<uint64_t>(static_cast<uint8_t>(tag)) << 56) | payload;
+    }
+
+    void clear();
+    void countElement(char container);
+    void addWord(char tag, uint64_t payload);
+    void addString(const char* s, size_t len);
+    void startContainer(char tag);
+    void endContainer(char tag);
+
+private:
+    std::vector<uint64_t> m_tape;
+    std::vector<char> m_strings;
+    std::vector<uint32_t> m_stack;//打开的'[' '{'在tape中的位置
+};
+
+inline uint64_t TapeValue::word() const {
+    return m_doc->m_tape[m_index];
+}
+
+inline char TapeValue::tag() const {
+    return static_cast<char>(word() >> 56);
+}
+
+template <typename Handler>
+bool TapeValue::accept(Handler& handler) const {
+    switch (getType()) {
+        case TYPE_NULL:
+            return handler.Null();
+        case TYPE_BOOL:
+            return handler.Bool(getBool());
+        case TYPE_INT32:
+            return handler.Int32(getInt32());
+        case TYPE_INT64:
+            return handler.Int64(getInt64());
+        case TYPE_DOUBLE:
+            return handler.Double(getDouble());
+        case TYPE_STRING:
+            return handler.String(getStringData(), getStringLength(), true);
+        case TYPE_ARRAY:
+            if (!handler.StartArray()) {
+                return false;
+            }
+            for (auto& value : getArray()) {
+                if (!value.accept(handler)) {
+                    return false;
+                }
+            }
+            return handler.EndArray();
+        case TYPE_OBJECT:
+            if (!handler.StartObject()) {
+                return false;
+            }
+            for (auto& member : getObject()) {
+                if (!handler.Key(member.m_key.getStringData(), member.m_key.getStringLength(), true) ||
+                    !member.m_value.accept(handler)) {
+                    return false;
+                }
+            }
+            return handler.EndObject();
+    }
+    return false;
+}
+
+}
+
+#endif
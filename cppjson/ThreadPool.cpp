@@ -0,0 +1,73 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace cppjson {
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        m_threads.emplace_back(&ThreadPool::loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::run(const std::function<void(size_t)>& task) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_task = &task;
+    m_running = m_threads.size();
+    m_error = nullptr;
+    m_generation++;
+    m_start.notify_all();
+    m_done.wait(lock, [this] { return m_running == 0; });
+    m_task = nullptr;
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::loop(size_t worker) {
+    uint64_t generation = 0;
+    while (true) {
+        const std::function<void(size_t)>* task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&] { return m_stop || m_generation != generation; });
+            if (m_stop) {
+                return;
+            }
+            generation = m_generation;
+            task = m_task;
+        }
+
+        std::exception_ptr error;
+        try {
+            (*task)(worker);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (error && !m_error) {
+            m_error = error;
+        }
+        if (--m_running == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+}
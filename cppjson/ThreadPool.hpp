@@ -0,0 +1,47 @@
+#ifndef CPPJSON_THREADPOOL_HPP
+#define CPPJSON_THREADPOOL_HPP
+
+#include "Nocopyable.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cppjson {
+
+//
+// 线程池: a fixed set of threads kept between runs.
+// run(task) calls task(worker) once on every thread, worker = 0 .. getSize() - 1, and waits for all of them;
+// the tasks share out the work themselves (e.g. through an atomic counter).
+// The first exception thrown by a task is rethrown by run().
+//
+class ThreadPool : public Nocopyable {
+public:
+    explicit ThreadPool(size_t threads = 0);//0: one thread per core
+    ~ThreadPool();
+
+    size_t getSize() const { return m_threads.size(); }
+
+    void run(const std::function<void(size_t)>& task);
+
+private:
+    void loop(size_t worker);
+
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const std::function<void(size_t)>* m_task = nullptr;
+    uint64_t m_generation = 0;//每次run()加一
+    size_t m_running = 0;
+    bool m_stop = false;
+    std::exception_ptr m_error;
+};
+
+}
+
+#endif
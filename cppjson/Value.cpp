@@ -1,75 +1,206 @@
 #include "Value.hpp"
+#include "KeyPool.hpp"
+#include "MemoryPool.hpp"
+#include "MemoryReadStream.hpp"
+#include "Reader.hpp"
+#include <cmath>
+#include <cstddef>
 #include <utility>
 #include <algorithm>
+#include <limits>
 
 namespace cppjson {
 Value::Value(ValueType type) : m_type(type), m_i64(0) {
+    static_assert(sizeof(Value) == 16 && offsetof(Value, m_length) == 4, "a short string fills bytes 2 .. 15");
+    static_assert(offsetof(Value, m_i64) == 2 + kRawShortCapacity, "a short raw number leaves the union free");
     switch (type) {
         case TYPE_STRING:
-            m_s = new std::vector<char>();
-            break;
-        case TYPE_ARRAY:
-            m_a = new std::vector<Value>();
-            break;
-        case TYPE_OBJECT:
-            m_o = new std::vector<Member>();
+            m_flags = kInlineFlag;//空的短字符串
             break;
     }
+    //数组和对象: 没有元素时不分配
+}
+
+static uint32_t checkLength(size_t len) {
+    if (len > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("cppjson: string longer than 4 GiB");
+    }
+    return static_cast<uint32_t>(len);
+}
+
+Value::Value(const char* s, size_t len, bool copy) : m_type(TYPE_STRING) {
+    if (copy) {
+        setText(s, len);
+    } else {
+        m_flags = kBorrowedFlag;
+        m_length = checkLength(len);
+        m_str = s;
+    }
+}
+
+Value::Value(std::unique_ptr<char[]> s, size_t len) : m_type(TYPE_STRING) {
+    if (len <= kShortCapacity) {
+        setShort(s.get(), len);
+    } else {
+        m_flags = kAdoptedFlag;
+        m_length = checkLength(len);
+        m_s = s.release();
+    }
+}
+
+// 堆上的文本前面是引用计数
+void Value::setText(const char* s, size_t len) {
+    if (len <= kShortCapacity) {
+        setShort(s, len);
+    } else {
+        m_length = checkLength(len);
+        RefCount* refs = new (::operator new(sizeof(RefCount) + len)) RefCount(1);
+        m_s = reinterpret_cast<char*>(refs + 1);
+        memcpy(m_s, s, len);
+    }
+}
+
+void Value::releaseText() {
+    if (m_flags & kAdoptedFlag) {
+        delete[] m_s;
+    } else if (m_flags & kInternFlag) {
+        KeyPool::release(m_str);
+    } else if (release(textRefs(m_s))) {
+        ::operator delete((m_flags & kRawNumberFlag) ? static_cast<void*>(rawSlot()) : &textRefs(m_s));
+    }
+}
+
+template <typename T>
+void Value::releaseElements(T* elements, size_t size) {
+    if (elements && release(blockRefs(elements))) {
+        Elements<T>::destroy(elements, size, true);
+    }
 }
+
+// 在MemoryPool里时只析构元素, the memory goes with the pool
+template <typename T>
+void Value::releaseBlock(T* elements) {
+    if (!(m_flags & kPoolFlag)) {
+        releaseElements(elements, m_length);
+        return;
+    }
+    if (elements == nullptr) {
+        return;
+    }
+    MemoryPool* pool = (m_flags & kPoolRefFlag) ? poolOf(elements) : nullptr;
+    if (release(blockRefs(elements))) {
+        Elements<T>::destroy(elements, m_length, false);
+    }
+    if (pool) {
+        pool->release();
+    }
+}
+
+// 元素逐个拷贝到一个刚好大小的块里
+template <typename T>
+static T* copyElements(const T* elements, size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+    T* data = static_cast<T*>(Value::Elements<T>::allocate(size));
+    size_t i = 0;
+    try {
+        for (; i < size; i++) {
+            new (data + i) T(elements[i]);
+        }
+    } catch (...) {
+        Value::Elements<T>::destroy(data, i, true);
+        throw;
+    }
+    return data;
+}
+
+// 文本在MemoryPool里时拷贝到堆上, everything else is shared: a block in a MemoryPool with a reference to the pool
 void Value::copyHelper(const Value& rhs) {
     m_type = rhs.m_type;
+    m_flags = rhs.m_flags;
+    memcpy(shortData(), rhs.shortData(), kShortCapacity);//标量、短字符串和借用的字符串到此为止
+    bool deep = false;
     switch(m_type) {
-        case TYPE_NULL:
-        case TYPE_BOOL:
         case TYPE_INT32:
         case TYPE_INT64:
-        case TYPE_DOUBLE: 
-            m_i64 = rhs.m_i64;
-            break;
+        case TYPE_DOUBLE:
         case TYPE_STRING:
-            m_s = new std::vector<char>(rhs.m_s->begin(), rhs.m_s->end());
+            deep = (m_flags & kPoolFlag) || (m_flags & (kInlineFlag | kAdoptedFlag)) == kAdoptedFlag;
+            if (deep) {//不是短字符串, 高位可以清掉
+                m_flags &= ~(kPoolFlag | kBorrowedFlag | kInternFlag | kAdoptedFlag);
+            }
+            if (!ownsText()) {
+                break;
+            }
+            if (deep && (m_flags & kRawNumberFlag)) {
+                setRawText(rhs.m_str, rhs.m_length);
+                *rawSlot() = *rhs.rawSlot();//连同转换后的值
+            } else if (deep) {
+                setText(rhs.textData(), rhs.textLength());
+            } else {
+                retain(textRefs(m_s));//驻留的键也是: the copy keeps the pointer
+            }
             break;
         case TYPE_ARRAY:
-            m_a = new std::vector<Value>(rhs.m_a->begin(), rhs.m_a->end());
+            if (m_a) {
+                retain(blockRefs(m_a));
+                if (m_flags & kPoolFlag) {
+                    poolOf(m_a)->retain();
+                    m_flags |= kPoolRefFlag;
+                }
+            }
             break;
         case TYPE_OBJECT:
-            m_o = new std::vector<Member>(rhs.m_o->begin(), rhs.m_o->end());
+            if (m_o) {
+                retain(blockRefs(m_o));
+                if (m_flags & kPoolFlag) {
+                    poolOf(m_o)->retain();
+                    m_flags |= kPoolRefFlag;
+                }
+            }
             break;
     }
 }
 
+// 写时复制: the elements are copied into a block of this Value's own, each copy shares what the element has
+void Value::unshare() {
+    if (m_type == TYPE_ARRAY) {
+        Value* old = m_a;
+        m_a = copyElements(old, m_length);
+        releaseBlock(old);
+        m_flags &= ~(kPoolFlag | kPoolRefFlag);
+    } else {
+        Member* old = m_o;
+        m_o = copyElements(old, m_length);
+        releaseBlock(old);
+        m_flags &= ~(kPoolFlag | kPoolRefFlag);
+        rebuildIndex();
+    }
+}
+
 void Value::moveHelper(Value&& rhs) {
     m_type = rhs.m_type;
-    switch(m_type) {
-        case TYPE_NULL:
-        case TYPE_BOOL:
-        case TYPE_INT32:
-        case TYPE_INT64:
-        case TYPE_DOUBLE: 
-            m_i64 = rhs.m_i64;
-            break;
-        case TYPE_STRING:
-            m_s = rhs.m_s;
-            rhs.m_s = nullptr;
-            break;
-        case TYPE_ARRAY:
-            m_a = rhs.m_a;
-            rhs.m_a = nullptr;
-            break;
-        case TYPE_OBJECT:
-            m_o = rhs.m_o;
-            rhs.m_o = nullptr;
-            break;
-    }
+    m_flags = rhs.m_flags;
+    memcpy(shortData(), rhs.shortData(), kShortCapacity);//指针、长度或短字符串整体搬过来
     rhs.m_type = TYPE_NULL;
+    rhs.m_flags = 0;
 }
 
 Value::Value(const Value& rhs):m_type(rhs.m_type) {//拷贝构造 
     copyHelper(rhs);
 }
 
-Value::Value(Value&& rhs) {//移动构造
-    moveHelper(std::move(rhs));
+// 移出MemoryPool: rhs may be moved out of its Document, which frees the pool, so it is copied: a pooled block is shared
+// with a reference to the pool, pooled text is copied to the heap (out of memory then terminates, as in any noexcept function).
+// Document moves within the pool with moveHelper()
+Value::Value(Value&& rhs) noexcept {//移动构造
+    if (inPool(rhs)) {
+        copyHelper(rhs);
+        rhs.setNull();
+    } else {
+        moveHelper(std::move(rhs));
+    }
 }
 
 Value& Value::operator=(const Value& rhs) {//拷贝=运算符重载
@@ -78,7 +209,14 @@ Value& Value::operator=(const Value& rhs) {//拷贝=运算符重载
     return *this;
 }
 
-Value& Value::operator=(Value&& rhs) {//移动=运算符重载
+Value& Value::operator=(Value&& rhs) noexcept {//移动=运算符重载
+    if (inPool(rhs)) {
+        Value copy(rhs);//rhs may be an element of this Value
+        rhs.setNull();
+        this->~Value();
+        moveHelper(std::move(copy));
+        return *this;
+    }
     this->~Value();
     moveHelper(std::move(rhs));
     return *this;
@@ -86,24 +224,283 @@ Value& Value::operator=(Value&& rhs) {//移动=运算符重载
 
 Value::~Value() {
     switch (m_type) {
+        case TYPE_INT32:
+        case TYPE_INT64:
+        case TYPE_DOUBLE:
         case TYPE_STRING:
-            delete m_s;
+            if (ownsText()) {
+                releaseText();
+            }
             break;
         case TYPE_ARRAY:
-            delete m_a;
+            releaseBlock(m_a);
             break;
         case TYPE_OBJECT:
-            delete m_o;
+            releaseBlock(m_o);
             break;
     }
     m_type = TYPE_NULL;
+    m_flags = 0;
     m_i64 = 0;
 }
-Value& Value::operator[] (std::string key) const{
+// 数字的类型由原文决定, 不做转换
+static ValueType rawNumberType(const char* s, size_t len) {
+    const char* end = s + len;
+    if (std::find_if(s, end, [](char c) { return c == '.' || c == 'e' || c == 'E'; }) != end) {
+        return TYPE_DOUBLE;
+    }
+    if (len > 3 && end[-3] == 'i') {
+        return end[-2] == '3' ? TYPE_INT32 : TYPE_INT64;
+    }
+    bool negative = *s == '-';
+    size_t digits = len - negative;
+    if (digits != 10) {
+        return digits < 10 ? TYPE_INT32 : TYPE_INT64;
+    }
+    // 10位: 与int32的边界逐位比较
+    return memcmp(s + negative, negative ? "2147483648" : "2147483647", 10) <= 0 ? TYPE_INT32 : TYPE_INT64;
+}
+
+Value& Value::setRawNumber(const char* s, size_t len, bool copy) {
+    this->~Value();
+    m_type = rawNumberType(s, len);
+    m_flags = kRawNumberFlag;
+    if (len <= kRawShortCapacity) {
+        setShort(s, len);
+    } else if (!copy && len <= std::numeric_limits<uint32_t>::max()) {
+        m_flags |= kBorrowedFlag;
+        m_length = static_cast<uint32_t>(len);
+        m_str = s;
+    } else {
+        setRawText(s, len);
+    }
+    return *this;
+}
+
+// [转换后的值][引用计数][文本]
+void Value::setRawText(const char* s, size_t len) {
+    m_length = checkLength(len);
+    char* block = static_cast<char*>(::operator new(sizeof(uint64_t) + sizeof(RefCount) + len));
+    RefCount* refs = new (block + sizeof(uint64_t)) RefCount(1);
+    m_s = reinterpret_cast<char*>(refs + 1);
+    memcpy(m_s, s, len);
+}
+
+uint64_t* Value::rawSlot() const {
+    if (m_flags & kInlineFlag) {
+        return reinterpret_cast<uint64_t*>(const_cast<int64_t*>(&m_i64));
+    }
+    if ((m_flags & (kBorrowedFlag | kPoolFlag)) == kBorrowedFlag) {
+        return nullptr;
+    }
+    const char* text = (m_flags & kPoolFlag) ? m_str : reinterpret_cast<const char*>(&textRefs(m_s));
+    return reinterpret_cast<uint64_t*>(const_cast<char*>(text)) - 1;
+}
+
+namespace {
+
+// 接收原文数字转换后的值
+struct NumberCapture {
+    int64_t m_i64 = 0;
+    double m_d = 0;
+
+    bool Null() { return false; }
+    bool Bool(bool) { return false; }
+    bool Int32(int32_t i32) { m_i64 = i32; return true; }
+    bool Int64(int64_t i64) { m_i64 = i64; return true; }
+    bool Double(double d) { m_d = d; return true; }
+    bool String(const char*, size_t, bool) { return false; }
+    bool Key(const char*, size_t, bool) { return false; }
+    bool StartArray() { return false; }
+    bool EndArray() { return false; }
+    bool StartObject() { return false; }
+    bool EndObject() { return false; }
+};
+
+}
+
+// 第一次读取时转换并缓存. Readers of one Value may run concurrently: they store the same bits,
+// the slot before the flag, so a reader that sees the flag sees the value
+static bool loadCached(const uint8_t& flags, const uint64_t* slot, uint8_t cachedFlag, uint64_t& bits) {
+    if (slot == nullptr || !(__atomic_load_n(&flags, __ATOMIC_ACQUIRE) & cachedFlag)) {
+        return false;
+    }
+    bits = __atomic_load_n(slot, __ATOMIC_RELAXED);
+    return true;
+}
+
+static void storeCached(uint8_t& flags, uint64_t* slot, uint8_t cachedFlag, uint64_t bits) {
+    if (slot != nullptr) {
+        __atomic_store_n(slot, bits, __ATOMIC_RELAXED);
+        __atomic_fetch_or(&flags, cachedFlag, __ATOMIC_RELEASE);
+    }
+}
+
+int64_t Value::rawInt64() const {
+    uint64_t* slot = rawSlot();
+    uint64_t bits;
+    if (loadCached(m_flags, slot, kRawCachedFlag, bits)) {
+        return static_cast<int64_t>(bits);
+    }
+    MemoryReadStream is(getRawNumberData(), getRawNumberLength());
+    NumberCapture capture;
+    ParseError err = Reader::parse(is, capture);
+    assert(err == PARSE_OK && "the range of an integer is checked by Reader");
+    (void)err;
+    storeCached(const_cast<uint8_t&>(m_flags), slot, kRawCachedFlag, static_cast<uint64_t>(capture.m_i64));
+    return capture.m_i64;
+}
+
+// beyond the range of a double: +-inf, as strtod gives
+double Value::rawDouble() const {
+    uint64_t* slot = rawSlot();
+    uint64_t bits;
+    double d;
+    if (loadCached(m_flags, slot, kRawCachedFlag, bits)) {
+        memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+    MemoryReadStream is(getRawNumberData(), getRawNumberLength());
+    NumberCapture capture;
+    if (Reader::parse(is, capture) == PARSE_NUMBER_TOO_BIG) {
+        d = *getRawNumberData() == '-' ? -HUGE_VAL : HUGE_VAL;
+    } else {
+        d = capture.m_d;
+    }
+    memcpy(&bits, &d, sizeof(d));
+    storeCached(const_cast<uint8_t&>(m_flags), slot, kRawCachedFlag, bits);
+    return d;
+}
+
+struct Value::MemberIndex {
+    struct Slot {
+        uint32_t m_hash;
+        uint32_t m_position;//成员下标加一, 0为空
+    };
+
+    size_t m_mask;
+    Slot m_slots[1];
+
+    static size_t bytes(size_t slots) { return sizeof(MemberIndex) + (slots - 1) * sizeof(Slot); }
+
+    void insert(const Member* members, size_t position);
+};
+
+// 8 bytes at a time
+uint32_t Value::hashKey(const char* s, size_t len) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ len;
+    for (; len >= 8; s += 8, len -= 8) {
+        uint64_t w;
+        memcpy(&w, s, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    if (len > 0) {
+        uint64_t w = 0;
+        memcpy(&w, s, len);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+    }
+    h ^= h >> 29;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+uint32_t Value::keyHash(const Value& key) {
+    if (key.isInterned()) {
+        return KeyPool::hashOf(key.m_str);
+    }
+    return hashKey(key.getStringData(), key.getStringLength());
+}
+
+// 同一个KeyPool里的键比较指针就够了
+static bool keyEquals(const Member& member, const char* s, size_t len) {
+    const char* key = member.m_key.getStringData();
+    return member.m_key.getStringLength() == len && (key == s || memcmp(key, s, len) == 0);
+}
+
+// 重复的键只记第一个, like a linear search finds it
+void Value::MemberIndex::insert(const Member* members, size_t position) {
+    const Value& key = members[position].m_key;
+    uint32_t hash = keyHash(key);
+    for (size_t i = hash & m_mask; ; i = (i + 1) & m_mask) {
+        auto& slot = m_slots[i];
+        if (slot.m_position == 0) {
+            slot.m_hash = hash;
+            slot.m_position = static_cast<uint32_t>(position + 1);
+            return;
+        }
+        if (slot.m_hash == hash && keyEquals(members[slot.m_position - 1], key.getStringData(), key.getStringLength())) {
+            return;
+        }
+    }
+}
+
+void Value::rebuildIndex(MemoryPool* pool) {
     assert(m_type == TYPE_OBJECT);
+    if (m_o == nullptr) {
+        return;
+    }
+    MemberIndex*& index = indexOf(m_o);
+    if (index == nullptr) {
+        if (m_length < kIndexThreshold) {
+            return;
+        }
+        assert((pool != nullptr) == ((m_flags & kPoolFlag) != 0));
+        size_t slots = 16;
+        while (slots < blockCapacity(m_o) * 2) {//负载不超过一半
+            slots *= 2;
+        }
+        size_t bytes = MemberIndex::bytes(slots);
+        index = static_cast<MemberIndex*>(pool ? pool->allocate(bytes, alignof(MemberIndex)) : ::operator new(bytes));
+        index->m_mask = slots - 1;
+    }
+    memset(index->m_slots, 0, (index->m_mask + 1) * sizeof(MemberIndex::Slot));
+    for (size_t i = 0; i < m_length; i++) {
+        index->insert(m_o, i);
+    }
+}
+
+void Value::indexAppended(Member*) {
+    MemberIndex* index = indexOf(m_o);
+    if (index == nullptr) {
+        rebuildIndex();//到了kIndexThreshold, or a new block
+    } else {
+        index->insert(m_o, m_length - 1);
+    }
+}
+
+void Value::releaseIndex(Member* elements) {
+    ::operator delete(indexOf(elements));
+}
+
+Member* Value::findKey(const char* s, size_t len) const {
+    assert(m_type == TYPE_OBJECT);
+    MemberIndex* index = m_o ? indexOf(m_o) : nullptr;
+    if (index == nullptr) {
+        for (size_t i = 0; i < m_length; i++) {
+            if (keyEquals(m_o[i], s, len)) {
+                return m_o + i;
+            }
+        }
+        return m_o + m_length;
+    }
+    uint32_t hash = hashKey(s, len);
+    for (size_t i = hash & index->m_mask; ; i = (i + 1) & index->m_mask) {
+        auto& slot = index->m_slots[i];
+        if (slot.m_position == 0) {
+            return m_o + m_length;
+        }
+        if (slot.m_hash == hash && keyEquals(m_o[slot.m_position - 1], s, len)) {
+            return m_o + slot.m_position - 1;
+        }
+    }
+}
 
-    auto it = findMember(key);
-    if (it != m_o->end()) {
+const Value& Value::operator[] (StringRef key) const{
+    assert(m_type == TYPE_OBJECT);
+
+    auto it = findKey(key.data(), key.size());
+    if (it != getObject().end()) {
         return it->m_value;
     }
 
@@ -112,39 +509,69 @@ Value& Value::operator[] (std::string key) const{
     return fake;
 }
 
-Value& Value::operator[](size_t i) const{
+Value& Value::operator[] (StringRef key) {
+    detach();
+    return const_cast<Value&>(static_cast<const Value&>(*this)[key]);
+}
+
+const Value& Value::operator[](size_t i) const{
     assert(m_type == TYPE_ARRAY);
-    return (*m_a)[i];
+    assert(i < m_length);
+    return m_a[i];
+}
+
+Value& Value::operator[](size_t i) {
+    assert(m_type == TYPE_ARRAY);
+    assert(i < m_length);
+    detach();
+    return m_a[i];
 }
 
 size_t Value::getSize() const {
-     if (m_type == TYPE_ARRAY) {
-        return m_a->size();
-     } else if (m_type == TYPE_OBJECT) {
-        return m_o->size();
+     if (m_type == TYPE_ARRAY || m_type == TYPE_OBJECT) {
+        return m_length;
      }
      return 1;
 }
 
-std::vector<Member>::iterator Value::findMember(std::string key) const{
+const Member* Value::findMember(StringRef key) const{
+    return findKey(key.data(), key.size());
+}
+
+Member* Value::findMember(StringRef key) {
     assert(m_type == TYPE_OBJECT);
-    return std::find_if(m_o->begin(), m_o->end(), [key](Member& m)->bool {
-        return m.m_key.getString() == key;
-    });
+    detach();
+    return findKey(key.data(), key.size());
 }
 
 void Value::addMember(const Value& key, const Value& value) {
     assert(m_type == TYPE_OBJECT);
     assert(key.m_type == TYPE_STRING);
-    assert(findMember(key.getString()) == m_o->end());
-    m_o->emplace_back(std::move(key), std::move(value));
+    assert(findKey(key.getStringData(), key.getStringLength()) == getObject().end());
+    getObject().emplace_back(key, value);
+}
+
+void Value::addMember(Value&& key, Value&& value) {
+    assert(m_type == TYPE_OBJECT);
+    assert(key.m_type == TYPE_STRING);
+    assert(findKey(key.getStringData(), key.getStringLength()) == getObject().end());
+    getObject().emplace_back(std::move(key), std::move(value));
+}
+
+void Value::reserve(size_t n) {
+    assert(m_type == TYPE_ARRAY || m_type == TYPE_OBJECT);
+    if (m_type == TYPE_ARRAY) {
+        getArray().reserve(n);
+    } else {
+        getObject().reserve(n);
+    }
 }
 
 
 
 Member::Member(const Member& member):m_key(member.m_key), m_value(member.m_value) {}
 
-Member::Member(Member&& member):m_key(std::move(member.m_key)), m_value(std::move(member.m_value)) {}
+Member::Member(Member&& member) noexcept:m_key(std::move(member.m_key)), m_value(std::move(member.m_value)) {}
 
 Member& Member::operator=(const Member& member) {
     m_key.~Value();
@@ -154,7 +581,7 @@ Member& Member::operator=(const Member& member) {
     return *this;
 }
 
-Member& Member::operator=(Member&& member) {
+Member& Member::operator=(Member&& member) noexcept {
     m_key.~Value();
     m_key = std::move(member.m_key);
     m_value.~Value();
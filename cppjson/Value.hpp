@@ -1,16 +1,24 @@
 #ifndef CPPJSON_VALUE_HPP
 #define CPPJSON_VALUE_HPP
 
+#include "MemoryPool.hpp"
+#include "StringRef.hpp"
 #include <atomic>
 #include <cassert>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 #include <stdint.h>
 #include <string>
 #include <cstring>
+#include <type_traits>
+#include <utility>
 
 namespace cppjson {
 
-enum ValueType {
+enum ValueType : uint8_t {
     TYPE_NULL,
     TYPE_BOOL,
     TYPE_INT32,
@@ -33,6 +41,13 @@ private:
     void moveHelper(Value&& rhs);
 
 public:
+    template <typename T>
+    class Elements;
+    using Array = Elements<Value>;
+    using Object = Elements<Member>;
+    using ConstArray = Elements<const Value>;
+    using ConstObject = Elements<const Member>;
+
     explicit Value(ValueType type = TYPE_NULL);
     
     explicit Value(bool b) : m_type(TYPE_BOOL), m_b(b) {}
@@ -43,19 +58,29 @@ public:
 
     explicit Value(double d) : m_type(TYPE_DOUBLE), m_d(d) {}
 
-    explicit Value(std::string s) : m_type(TYPE_STRING), m_s(new std::vector<char>(s.begin(), s.end())) {}
+    // up to kShortCapacity bytes are kept in the Value itself, longer strings on the heap
+    explicit Value(const std::string& s) : Value(s.data(), s.size(), true) {}
+
+    explicit Value(StringRef s) : Value(s.data(), s.size(), true) {}
+
+    explicit Value(const char* s) : Value(s, strlen(s), true) {}
 
-    explicit Value(const char* s) : m_type(TYPE_STRING), m_s(new std::vector<char>(s, s + strlen(s))) {}
+    explicit Value(const char* s, size_t len) : Value(s, len, true) {}
 
-    explicit Value(const char* s, size_t len) : Value(std::string(s, len)) {}
+    // copy == false: the string is borrowed, s must outlive this Value (and its copies)
+    Value(const char* s, size_t len, bool copy);
+
+    // 接管s: a buffer from new char[], freed by this Value (a short string is copied and s freed at once);
+    // unlike the other strings it is not shared, a copy of it copies the text
+    Value(std::unique_ptr<char[]> s, size_t len);
 
     Value(const Value& rhs);//拷贝构造
 
-    Value(Value&& rhs);//移动构造
+    Value(Value&& rhs) noexcept;//移动构造
 
     Value& operator=(const Value& rhs);//拷贝=运算符重载
 
-    Value& operator=(Value&& rhs);//移动=运算符重载
+    Value& operator=(Value&& rhs) noexcept;//移动=运算符重载
 
     ~Value();
 
@@ -68,6 +93,7 @@ public:
     bool isInt64() const{ return m_type == TYPE_INT64 || m_type == TYPE_INT32; }
     bool isDouble() const{ return m_type == TYPE_DOUBLE; }
     bool isString() const{ return m_type == TYPE_STRING; }
+    bool isRawNumber() const{ return m_flags & kRawNumberFlag; }//数字保存为原文, 见setRawNumber()
     bool isArray()  const{ return m_type == TYPE_ARRAY; }
     bool isObject() const{ return m_type == TYPE_OBJECT; }
 
@@ -79,34 +105,74 @@ public:
 
     int32_t getInt32() const {
         assert(m_type == TYPE_INT32);
+        if (m_flags & kRawNumberFlag) {
+            return static_cast<int32_t>(rawInt64());
+        }
         return m_i32;
     }
 
     int64_t getInt64() const{
         assert(m_type == TYPE_INT64 || m_type == TYPE_INT32);
+        if (m_flags & kRawNumberFlag) {
+            return rawInt64();
+        }
         return m_type == TYPE_INT64 ? m_i64 : m_i32;
     }
 
     double getDouble() const{
         assert(m_type == TYPE_DOUBLE);
+        if (m_flags & kRawNumberFlag) {
+            return rawDouble();
+        }
         return m_d;
     }
 
     std::string getString() const{
         assert(m_type == TYPE_STRING);
-        return std::string(&*m_s->begin(), m_s->size());
+        return std::string(textData(), textLength());
+    }
+
+    // 不拷贝: the bytes of the string, not '\0'-terminated
+    const char* getStringData() const {
+        assert(m_type == TYPE_STRING);
+        return textData();
     }
 
-    auto& getArray() const{
-        assert(m_type == TYPE_ARRAY);
-        return *m_a;
+    size_t getStringLength() const {
+        assert(m_type == TYPE_STRING);
+        return textLength();
+    }
+
+    StringRef getStringRef() const {
+        assert(m_type == TYPE_STRING);
+        return StringRef(textData(), textLength());
+    }
+
+#if __cplusplus >= 201703L
+    std::string_view getStringView() const { return getStringRef(); }
+#endif
+
+    // the number exactly as it was in the input, see setRawNumber()
+    const char* getRawNumberData() const {
+        assert(isRawNumber());
+        return textData();
     }
 
-    auto& getObject() const{
-        assert(m_type == TYPE_OBJECT);
-        return *m_o;
+    size_t getRawNumberLength() const {
+        assert(isRawNumber());
+        return (m_flags & kInlineFlag) ? ((m_flags & ~kRawCachedFlag) >> kShortLengthShift) : m_length;
     }
 
+    // 视图: the elements stay in this Value, the view is cheap to copy.
+    // 写时复制: a copy of a Value shares its heap strings and its elements, those in a Document's pool too;
+    // a non-const view (or operator[], findMember) first gives this Value elements of its own, copied one level down,
+    // the children still shared until they are changed. A view does so again on each access, so one taken before
+    // the Value is copied stays safe to write through, a reference or an iterator taken before must not be
+    Array getArray();
+    Object getObject();
+    ConstArray getArray() const;
+    ConstObject getObject() const;
+
     Value& setNull() {
         this->~Value();
         return *new (this) Value(TYPE_NULL);
@@ -132,11 +198,23 @@ public:
         return *new (this) Value(d);
     }
 
-    Value& setString(std::string s) {
-        this->~Value();
-        return *new (this) Value(s);
+    // s may be (a part of) this Value's own string
+    Value& setString(StringRef s) {
+        return *this = Value(s);
+    }
+
+    Value& setString(std::unique_ptr<char[]> s, size_t len) {
+        return *this = Value(std::move(s), len);
     }
 
+    // 原文数字: s is a JSON number (as checked by Reader), kept as text and typed TYPE_INT32/INT64/DOUBLE,
+    // Writer writes the text back unchanged. The first getInt32()/getInt64()/getDouble() converts the text and caches
+    // the value: up to kRawShortCapacity bytes the text and the value are both in the Value, a longer text has a slot in front.
+    // A double out of range (1e309) is kept, getDouble() gives +-HUGE_VAL; without kParseRawNumbers it is PARSE_NUMBER_TOO_BIG.
+    // copy == false: s is borrowed like a string (up to kRawShortCapacity bytes are always stored in the Value itself),
+    // there is no slot then and every read converts the text again
+    Value& setRawNumber(const char* s, size_t len, bool copy = true);
+
     Value& setArray() {
         this->~Value();
         return *new (this) Value(TYPE_ARRAY);
@@ -147,46 +225,439 @@ public:
         return *new (this) Value(TYPE_OBJECT);
     }
 
-    Value& operator[] (std::string key) const;
-    Value& operator[] (size_t i) const;
+    // key: a literal, a std::string, ..., see StringRef
+    Value& operator[] (StringRef key);
+    const Value& operator[] (StringRef key) const;
+    Value& operator[] (size_t i);
+    const Value& operator[] (size_t i) const;
 
-    std::vector<Member>::iterator findMember(std::string key) const;
+    // getObject().end() when there is no such key; objects of kIndexThreshold members or more have a hash index,
+    // so a key is not to be changed in place
+    Member* findMember(StringRef key);
+    const Member* findMember(StringRef key) const;
     void addMember(const Value& key, const Value& value);
+    void addMember(Value&& key, Value&& value);
     
     template <typename T>
-    void addValue(T&& value) {
-        assert(m_type == TYPE_ARRAY);
-        m_a->emplace_back(std::forward<T>(value));
-    }
+    void addValue(T&& value);
+
+    // 数组或对象预留n个元素
+    void reserve(size_t n);
+
+public:
+    enum { kShortCapacity = 14 };//短字符串的最大长度
+    enum { kRawShortCapacity = 6 };//存在Value里的原文数字的最大长度, bytes 8 .. 15 hold the converted value
+    enum { kIndexThreshold = 16 };//对象的成员数达到它时建哈希索引
+
+    static uint32_t hashKey(const char* s, size_t len);
 
 protected:
+    enum {
+        kBorrowedFlag = 0x01,//m_str指向外部内存(如原地解析的缓冲区), 不归Value所有
+        kRawNumberFlag = 0x02,//数字, 以原文保存在m_s/m_str/短字符串中
+        kInlineFlag = 0x04,//短字符串: 文本在shortData()里, 长度在m_flags的高4位
+        kPoolFlag = 0x08,//m_str或m_a/m_o的元素块在Document的MemoryPool里: 文本拷贝时深拷贝到堆上, the block is shared
+        kInternFlag = 0x10,//m_str来自KeyPool, 前面存着哈希, 引用计数和堆上的字符串在同一位置; only on strings that are not short
+        kAdoptedFlag = 0x20,//m_s是接管的new char[], 没有引用计数; 同样只用于不是短字符串的
+        kPoolRefFlag = 0x40,//数组和对象: the pooled block was shared by a copy, which holds a reference to its MemoryPool
+        kRawCachedFlag = 0x80,//原文数字已转换, 值在rawSlot()里; an inline raw number is at most 6 bytes, so the bit is free
+        kShortLengthShift = 4,
+    };
+
+    // 引用计数: in front of a heap string and at the start of an element block, shared by the copies
+    using RefCount = std::atomic<size_t>;
+
+    static void retain(RefCount& refs) { refs.fetch_add(1, std::memory_order_relaxed); }
+
+    // true: the last one, to be freed
+    static bool release(RefCount& refs) {
+        return refs.load(std::memory_order_acquire) == 1 || refs.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    static RefCount& textRefs(char* s) { return reinterpret_cast<RefCount*>(s)[-1]; }
+
+    // 元素块: [MemberIndex*][RefCount][size_t capacity][elements ...], the index pointer only in front of members;
+    // m_a/m_o point to the first element and m_length is the size, an array or object without elements has no block.
+    // A block in a MemoryPool has the pool in front of it, [MemoryPool*][header][elements ...]: the Values of its Document
+    // rely on the pool to be there, a copy sharing the block holds a reference to the pool (kPoolRefFlag)
+    struct MemberIndex;
+
+    static_assert(sizeof(RefCount) == sizeof(size_t), "the header is made of size_t slots");
+
+    static constexpr size_t headerSize(const Value*) { return sizeof(RefCount) + sizeof(size_t); }
+    static constexpr size_t headerSize(const Member*) { return sizeof(RefCount) + sizeof(size_t) + sizeof(MemberIndex*); }
+
+    static RefCount& blockRefs(const void* elements) {
+        return const_cast<RefCount*>(static_cast<const RefCount*>(elements))[-2];
+    }
+
+    static size_t blockCapacity(const void* elements) {
+        return elements ? static_cast<const size_t*>(elements)[-1] : 0;
+    }
+
+    static MemberIndex*& indexOf(Member* elements) {
+        return reinterpret_cast<MemberIndex**>(elements)[-3];
+    }
+
+    template <typename T>
+    static MemoryPool* poolOf(const T* elements) {
+        return reinterpret_cast<MemoryPool* const*>(reinterpret_cast<const char*>(elements) - headerSize(elements))[-1];
+    }
+
+    static void* initBlock(void* block, size_t capacity, size_t header) {
+        memset(block, 0, header);
+        void* elements = static_cast<char*>(block) + header;
+        new (&blockRefs(elements)) RefCount(1);
+        static_cast<size_t*>(elements)[-1] = capacity;
+        return elements;
+    }
+
+    static void* allocateBlock(size_t capacity, size_t elementSize, size_t header) {
+        return initBlock(::operator new(header + capacity * elementSize), capacity, header);
+    }
+
+    static void freeBlock(void* elements, size_t header) {
+        if (elements) {
+            ::operator delete(static_cast<char*>(elements) - header);
+        }
+    }
+
+    Value* elementsOf(Value*) const { return m_a; }
+    Member* elementsOf(Member*) const { return m_o; }
+    const Value* elementsOf(const Value*) const { return m_a; }
+    const Member* elementsOf(const Member*) const { return m_o; }
+    void setElements(Value* a) { m_a = a; }
+    void setElements(Member* o) { m_o = o; }
+
+    // 对象的哈希索引: open addressing over member positions, sized for the capacity of the block.
+    // pool: the block is in this pool, so is the index
+    void rebuildIndex(MemoryPool* pool = nullptr);
+    void indexAppended(Value*) {}
+    void indexAppended(Member*);
+    void reindex(Value*) {}
+    void reindex(Member*) { rebuildIndex(); }
+    static void releaseIndex(Value*) {}
+    static void releaseIndex(Member* elements);
+
+    Member* findKey(const char* s, size_t len) const;
+
+    // 写时复制: before the elements are changed, in a MemoryPool too
+    void detach() {
+        if ((m_type == TYPE_ARRAY || m_type == TYPE_OBJECT) && m_a
+            && blockRefs(m_a).load(std::memory_order_acquire) != 1) {
+            unshare();
+        }
+    }
+
+    void unshare();
+
+    template <typename T>
+    static void releaseElements(T* elements, size_t size);//不是MemoryPool里的块
+
+    template <typename T>
+    void releaseBlock(T* elements);//m_a或m_o, 在哪里都行
+
+    // 值(或成员的键、值)的文本或元素块在MemoryPool里, without a reference to it: it lives only as long as its Document
+    static bool inPool(const Value& value) { return (value.m_flags & (kPoolFlag | kPoolRefFlag)) == kPoolFlag; }
+    static bool inPool(const Member& member);
+
+    bool isInterned() const { return (m_flags & (kInlineFlag | kInternFlag)) == kInternFlag; }
+    static uint32_t keyHash(const Value& key);//KeyPool里的键不再算
+
+    // 短字符串占用m_type、m_flags之后的全部字节(m_length和union)
+    char* shortData() { return reinterpret_cast<char*>(this) + 2; }
+    const char* shortData() const { return reinterpret_cast<const char*>(this) + 2; }
+
+    void setShort(const char* s, size_t len) {
+        assert(len <= kShortCapacity);
+        m_flags |= kInlineFlag | static_cast<uint8_t>(len << kShortLengthShift);
+        memcpy(shortData(), s, len);
+    }
+
+    const char* textData() const {
+        return (m_flags & kInlineFlag) ? shortData() : m_str;
+    }
+
+    size_t textLength() const {
+        return (m_flags & kInlineFlag) ? (m_flags >> kShortLengthShift) : m_length;
+    }
+
+    void setText(const char* s, size_t len);//复制到堆上(或短字符串)
+    void releaseText();
+
+    // m_s归Value所有(也许和拷贝共享): a string or a raw number that is neither borrowed nor inline
+    bool ownsText() const {
+        return (m_type == TYPE_STRING || (m_flags & kRawNumberFlag)) && !(m_flags & (kBorrowedFlag | kInlineFlag));
+    }
+
+    // 原文数字转换后的值: in m_i64 beside an inline text, in front of a text in a MemoryPool,
+    // in front of the reference count of a heap text; a borrowed text has none
+    uint64_t* rawSlot() const;
+    void setRawText(const char* s, size_t len);//复制到堆上, 前面留出rawSlot()
+    int64_t rawInt64() const;
+    double rawDouble() const;
+
     ValueType m_type;
+    uint8_t m_flags = 0;
+    uint32_t m_length = 0;//字符串(不是短字符串)的长度, 数组和对象的元素个数
     union {
         bool     m_b;
         int32_t  m_i32;
         int64_t  m_i64;
         double   m_d;
-        std::vector<char>*  m_s;
-        std::vector<Value>*   m_a;
-        std::vector<Member>*  m_o;
+        char*    m_s;
+        const char*  m_str;
+        Value*   m_a;
+        Member*  m_o;
     };
 };
 
 struct Member {
     Member(const Value& key, const Value& value): m_key(key), m_value(value) {}
     Member(Value&& key, Value&& value): m_key(std::move(key)), m_value(std::move(value)) {}
-    Member(std::string key, Value&& value): m_key(key), m_value(std::move(value)) {}
+    Member(StringRef key, Value&& value): m_key(key), m_value(std::move(value)) {}
 
     Member(const Member& member);
-    Member(Member&& member);
+    Member(Member&& member) noexcept;
 
     Member& operator=(const Member& member);
-    Member& operator=(Member&& member);
+    Member& operator=(Member&& member) noexcept;
 
     Value m_key;
     Value m_value;
 };
 
+inline bool Value::inPool(const Member& member) {
+    return inPool(member.m_key) || inPool(member.m_value);
+}
+
+//
+// 数组(T = Value)或对象(T = Member)的元素, like a std::vector whose size and pointer are kept in the Value.
+// Growing a block from a MemoryPool moves the elements to the heap. Iterators are plain pointers,
+// they are invalidated when the block grows. T = const Value/Member: a read-only view, see getArray() const.
+// A view taken before its Value was copied detaches the Value before it gives out an element or changes it
+//
+template <typename T>
+class Value::Elements {
+    using Owner = typename std::conditional<std::is_const<T>::value, const Value, Value>::type;
+public:
+    using value_type = typename std::remove_const<T>::type;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    explicit Elements(Owner* value) : m_value(value) {}
+
+    T* begin() const {
+        own(std::is_const<T>());
+        return m_value->elementsOf(static_cast<T*>(nullptr));
+    }
+    T* end() const { return begin() + size(); }
+    T* data() const { return begin(); }
+    size_t size() const { return m_value->m_length; }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return blockCapacity(begin()); }
+
+    T& operator[](size_t i) const {
+        assert(i < size());
+        return begin()[i];
+    }
+
+    T& front() const { return (*this)[0]; }
+    T& back() const { return (*this)[size() - 1]; }
+
+    void reserve(size_t n) const {
+        m_value->detach();
+        if (n > capacity()) {
+            T* data = allocate(n);
+            try {
+                relocate(data);
+            } catch (...) {
+                freeBlock(data, headerSize(data));
+                throw;
+            }
+            m_value->reindex(begin());
+        }
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) const {
+        m_value->detach();
+        size_t n = size();
+        if (n == capacity()) {
+            // 新元素先构造, args may refer to an element of the old block
+            T* data = allocate(n < 4 ? 4 : n * 2);
+            try {
+                new (data + n) T(std::forward<Args>(args)...);
+            } catch (...) {
+                freeBlock(data, headerSize(data));
+                throw;
+            }
+            try {
+                relocate(data);
+            } catch (...) {
+                data[n].~T();
+                freeBlock(data, headerSize(data));
+                throw;
+            }
+        } else {
+            new (begin() + n) T(std::forward<Args>(args)...);
+        }
+        T& element = begin()[n];
+        if (!(m_value->m_flags & kPoolFlag) && inPool(element)) {
+            // 移出MemoryPool: what a block on the heap has in a pool holds a reference to it, so its copies may share it
+            try {
+                element = T(static_cast<const T&>(element));
+            } catch (...) {
+                element.~T();
+                throw;
+            }
+        }
+        m_value->m_length = checkSize(n + 1);
+        m_value->indexAppended(begin());
+        return begin()[n];
+    }
+
+    void push_back(const T& x) const { emplace_back(x); }
+    void push_back(T&& x) const { emplace_back(std::move(x)); }
+
+    void pop_back() const {
+        assert(!empty());
+        m_value->detach();
+        back().~T();
+        m_value->m_length--;
+        m_value->reindex(begin());
+    }
+
+    // 数组新增null; an object has no default member, use resize(n, x)
+    void resize(size_t n) const {
+        static_assert(std::is_default_constructible<value_type>::value, "an object is resized by resize(n, member)");
+        resize(n, value_type());
+    }
+
+    // 新增的元素是x的拷贝
+    void resize(size_t n, const value_type& x) const {
+        if (n <= size()) {
+            shrink(n);
+            return;
+        }
+        checkSize(n);
+        value_type copy(x);//x may be an element, reserve() moves them
+        reserve(n);//也detach
+        try {
+            for (size_t i = size(); i < n; i++) {
+                new (begin() + i) T(static_cast<const value_type&>(copy));
+                m_value->m_length = static_cast<uint32_t>(i + 1);
+            }
+        } catch (...) {
+            m_value->reindex(begin());
+            throw;
+        }
+        m_value->reindex(begin());
+    }
+
+    void clear() const { shrink(0); }
+
+    // 块的分配和释放, for Value and Document
+    static T* allocate(size_t capacity) {
+        return static_cast<T*>(allocateBlock(capacity, sizeof(T), headerSize(static_cast<T*>(nullptr))));
+    }
+
+    static void destroy(T* elements, size_t size, bool free) {
+        for (size_t i = 0; i < size; i++) {
+            elements[i].~T();
+        }
+        if (free && elements) {
+            releaseIndex(elements);
+            freeBlock(elements, headerSize(elements));
+        }
+    }
+
+private:
+    void own(std::false_type) const { m_value->detach(); }
+    void own(std::true_type) const {}
+
+    static uint32_t checkSize(size_t n) {
+        if (n > UINT32_MAX) {
+            throw std::length_error("cppjson: too many elements");
+        }
+        return static_cast<uint32_t>(n);
+    }
+
+    void shrink(size_t n) const {
+        m_value->detach();
+        for (size_t i = n; i < size(); i++) {
+            begin()[i].~T();
+        }
+        m_value->m_length = static_cast<uint32_t>(n);
+        m_value->reindex(begin());
+    }
+
+    // 元素搬到data, 旧块在堆上时释放.
+    // 旧块在MemoryPool里时元素拷贝出来, as what a heap block has in a pool must hold a reference to it;
+    // data is left empty if a copy throws
+    void relocate(T* data) const {
+        T* old = begin();
+        bool pooled = m_value->m_flags & kPoolFlag;
+        MemoryPool* pool = (m_value->m_flags & kPoolRefFlag) ? poolOf(old) : nullptr;
+        size_t i = 0;
+        try {
+            for (; i < size(); i++) {
+                if (pooled) {
+                    new (data + i) T(static_cast<const T&>(old[i]));
+                } else {
+                    new (data + i) T(std::move(old[i]));
+                }
+            }
+        } catch (...) {
+            destroy(data, i, false);
+            throw;
+        }
+        for (i = 0; i < size(); i++) {
+            old[i].~T();
+        }
+        if (!pooled && old) {
+            releaseIndex(old);
+            freeBlock(old, headerSize(old));
+        }
+        if (pool) {
+            pool->release();
+        }
+        m_value->m_flags &= ~(kPoolFlag | kPoolRefFlag);
+        m_value->setElements(data);
+    }
+
+private:
+    Owner* m_value;
+};
+
+inline Value::Array Value::getArray() {
+    assert(m_type == TYPE_ARRAY);
+    detach();
+    return Array(this);
+}
+
+inline Value::Object Value::getObject() {
+    assert(m_type == TYPE_OBJECT);
+    detach();
+    return Object(this);
+}
+
+inline Value::ConstArray Value::getArray() const {
+    assert(m_type == TYPE_ARRAY);
+    return ConstArray(this);
+}
+
+inline Value::ConstObject Value::getObject() const {
+    assert(m_type == TYPE_OBJECT);
+    return ConstObject(this);
+}
+
+template <typename T>
+void Value::addValue(T&& value) {
+    assert(m_type == TYPE_ARRAY);
+    getArray().emplace_back(std::forward<T>(value));
+}
+
 
 }
 
@@ -1,4 +1,5 @@
 #include "Writer.hpp"
+#include <limits>
 
 
 namespace cppjson {
@@ -26,6 +27,17 @@ static unsigned countDigits(uint32_t n) {
     return t - (n < powers_of_10[t]) + 1;
 }
 
+static unsigned countDigits(uint64_t n) {
+    if (n <= std::numeric_limits<uint32_t>::max()) {
+        return countDigits(static_cast<uint32_t>(n));
+    }
+    unsigned count = 10;
+    for (n /= 10000000000ULL; n != 0; n /= 10) {
+        count++;
+    }
+    return count;
+}
+
 template <typename T>
 static unsigned itoa_(T val, char* buf) {
     static_assert(std::is_unsigned<T>::value, "must be unsigned integer");
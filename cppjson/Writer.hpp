@@ -17,7 +17,11 @@ public:
 
 #define CALL(expr) do { if (!(expr)) return false; } while(false)
     
-    bool fromValue(Value& value) {
+    // 只读: a copy sharing its blocks (see Value) still shares them after it is written
+    bool fromValue(const Value& value) {
+        if (value.isRawNumber()) {
+            return RawNumber(value.getRawNumberData(), value.getRawNumberLength(), true);
+        }
         switch(value.getType()) {
             case TYPE_NULL:
                 CALL(Null());
@@ -35,7 +39,7 @@ public:
                 CALL(Double(value.getDouble()));
                 break;
             case TYPE_STRING:
-                CALL(String(value.getString()));
+                CALL(String(value.getStringData(), value.getStringLength(), true));
                 break;
             case TYPE_ARRAY:
                 CALL(StartArray());
@@ -47,7 +51,7 @@ public:
             case TYPE_OBJECT:
                 CALL(StartObject());
                 for (auto& mem : value.getObject()) {
-                    CALL(Key(mem.m_key.getString()));
+                    CALL(Key(mem.m_key.getStringData(), mem.m_key.getStringLength(), true));
                     CALL(fromValue(mem.m_value));
                 }
                 CALL(EndObject());
@@ -107,10 +111,23 @@ public:
         return true;
     }
 
-    virtual bool String(std::string s) {
+    // the number as it was in the input (kParseRawNumbers), written back unchanged
+    virtual bool RawNumber(const char* s, size_t len, bool) {
+        prefix(TYPE_DOUBLE);
+        m_os.put(s, len);
+        return true;
+    }
+
+    bool String(const std::string& s) {
+        return String(s.data(), s.size(), true);
+    }
+
+    // copy is meaningless for a writer, the bytes are written out before returning
+    virtual bool String(const char* s, size_t len, bool) {
         prefix(TYPE_STRING);
         m_os.put('\"');
-        for (auto c : s) {
+        for (size_t i = 0; i < len; i++) {
+            char c = s[i];
             auto u = static_cast<unsigned>(c);
             switch(u) {
                 case '\"': m_os.put("\\\""); break;
@@ -150,10 +167,14 @@ public:
         return true;
     }
 
-    virtual bool Key(std::string s) {
+    bool Key(const std::string& s) {
+        return Key(s.data(), s.size(), true);
+    }
+
+    virtual bool Key(const char* s, size_t len, bool) {
         prefix(TYPE_STRING);
         m_os.put('\"');
-        m_os.put(s);
+        m_os.put(s, len);
         m_os.put('\"');
         return true;
     }
@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 
+#include "cppjson/BufferedFileReadStream.hpp"
 #include "cppjson/Document.hpp"
+#include "cppjson/StringReadStream.hpp"
+
+#include <cstdio>
+#include <string>
 
 using namespace cppjson;
 
@@ -32,6 +37,9 @@ TEST(json_error, bad_value) {
     TEST_ERROR(err, "[null,]");
     TEST_ERROR(err, "1.0i32");
     TEST_ERROR(err, "0.0i64");
+    TEST_ERROR(err, "1i");
+    TEST_ERROR(err, "1i3");
+    TEST_ERROR(err, "-");
 }
 
 TEST(json_error, root_not_singular) {
@@ -56,6 +64,8 @@ TEST(json_error, num_too_big) {
     TEST_ERROR(err, "-9223372036854775809i64");
     TEST_ERROR(err, "12345678901i32");
     TEST_ERROR(err, "-12345678901i32i32");
+    TEST_ERROR(err, "123456789012345678901");
+    TEST_ERROR(err, "1e99999999999999999999");
 }
 
 TEST(json_error, bad_string_char)
@@ -63,6 +73,7 @@ TEST(json_error, bad_string_char)
     ParseError err = PARSE_BAD_STRING_CHAR;
     TEST_ERROR(err, "\"abcd\1efg\"");
     TEST_ERROR(err, "\"\b\"");
+    TEST_ERROR(err, "\"" + std::string(40, 'x') + "\x1f" + std::string(40, 'x') + "\"");
 }
 
 TEST(json_error, bad_string_escape)
@@ -96,6 +107,7 @@ TEST(json_error, miss_quotation_mark)
     TEST_ERROR(err, "\"wtf");
     TEST_ERROR(err, "\"wtf""");
     TEST_ERROR(err, "\"xx\\\"");
+    TEST_ERROR(err, "\"" + std::string(100, 'x'));
 }
 
 TEST(json_error, miss_comma_or_square_bracket)
@@ -127,6 +139,58 @@ TEST(json_error, miss_comma_or_curly_bracket)
     TEST_ERROR(err, "{\"hehe\":false, \"\":\"蛤\"");
 }
 
+#define TEST_LOCATION(err, offset, line, column, json) do { \
+    std::string s(json); \
+    Document doc; \
+    ParseResult result; \
+    EXPECT_EQ(err, doc.parse(s.data(), s.size(), result)) << s; \
+    EXPECT_EQ(err, result.m_error) << s; \
+    EXPECT_EQ(offset, result.m_offset) << s; \
+    EXPECT_EQ(line, result.m_line) << s; \
+    EXPECT_EQ(column, result.m_column) << s; \
+} while(false)
+
+TEST(json_error, location)
+{
+    TEST_LOCATION(PARSE_OK, 0u, 0u, 0u, "[1, 2]");
+    TEST_LOCATION(PARSE_EXPECT_VALUE, 0u, 1u, 1u, "");
+    TEST_LOCATION(PARSE_ROOT_NOT_SINGULAR, 4u, 1u, 5u, "[1] x");
+    TEST_LOCATION(PARSE_BAD_VALUE, 9u, 3u, 2u, "[1,\n 2,\n x]");
+    TEST_LOCATION(PARSE_BAD_VALUE, 5u, 2u, 3u, "[\r\n 01]");
+    TEST_LOCATION(PARSE_MISS_COLON, 12u, 2u, 5u, "{\"a\":1,\n\"b\" 2}");
+    TEST_LOCATION(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, 7u, 2u, 4u, "[1,\n[2 3]]");
+    TEST_LOCATION(PARSE_MISS_COMMA_OR_CURLY_BRACKET, 8u, 3u, 1u, "{\"a\":1\n\n");
+    TEST_LOCATION(PARSE_MISS_KEY, 7u, 1u, 8u, "{\"a\":1,}");
+    TEST_LOCATION(PARSE_DEPTH_EXCEEDED, 1024u, 1u, 1025u, std::string(1025, '['));
+
+    // a stream that keeps its whole input gives the line too
+    std::string json = "[1,\n 2,\n x]";
+    StringReadStream is(json);
+    Document doc;
+    ParseResult result;
+    EXPECT_EQ(PARSE_BAD_VALUE, Reader::parse(is, doc, result));
+    EXPECT_EQ(9u, result.m_offset);
+    EXPECT_EQ(3u, result.m_line);
+    EXPECT_EQ(2u, result.m_column);
+
+    // in-situ decoding and a file window don't: the offset only
+    std::string insitu = json;
+    InsituStringStream in(&insitu[0], insitu.size());
+    EXPECT_EQ(PARSE_BAD_VALUE, doc.parseStream(in, result));
+    EXPECT_EQ(9u, result.m_offset);
+    EXPECT_EQ(0u, result.m_line);
+
+    FILE* f = tmpfile();
+    ASSERT_NE(nullptr, f);
+    fputs((std::string(5000, ' ') + json).c_str(), f);
+    rewind(f);
+    BufferedFileReadStream file(f, 64);
+    EXPECT_EQ(PARSE_BAD_VALUE, doc.parseStream(file, result));
+    EXPECT_EQ(5009u, result.m_offset);
+    EXPECT_EQ(0u, result.m_line);
+    fclose(f);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
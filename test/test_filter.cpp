@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include "cppjson/BufferedFileReadStream.hpp"
+#include "cppjson/Document.hpp"
+#include "cppjson/PathFilter.hpp"
+#include "cppjson/StringReadStream.hpp"
+#include "cppjson/StringWriteStream.hpp"
+#include "cppjson/Writer.hpp"
+
+using namespace cppjson;
+
+static std::string filterEvents(const PathFilter& filter, const std::string& json, ParseError& err) {
+    StringReadStream is(json);
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    err = filter.parse(is, writer);
+    return os.get();
+}
+
+// the same filter over a file read through a small buffer, every token is cut by a refill somewhere
+static std::string filterFileEvents(const PathFilter& filter, const std::string& json, size_t bufferSize, ParseError& err) {
+    FILE* fp = tmpfile();
+    fwrite(json.data(), 1, json.size(), fp);
+    rewind(fp);
+    BufferedFileReadStream is(fp, bufferSize);
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    err = filter.parse(is, writer);
+    fclose(fp);
+    return os.get();
+}
+
+#define TEST_FILTER(expect, json, ...) do { \
+    PathFilter filter; \
+    for (const char* pointer : {__VA_ARGS__}) { \
+        EXPECT_TRUE(filter.add(pointer)) << pointer; \
+    } \
+    std::string s(json); \
+    ParseError err; \
+    EXPECT_EQ(expect, filterEvents(filter, s, err)) << s; \
+    EXPECT_EQ(PARSE_OK, err) << s; \
+    for (size_t bufferSize : {1, 3, 7}) { \
+        EXPECT_EQ(expect, filterFileEvents(filter, s, bufferSize, err)) << s << " buffer " << bufferSize; \
+        EXPECT_EQ(PARSE_OK, err) << s << " buffer " << bufferSize; \
+    } \
+} while(false)
+
+#define TEST_FILTER_ERROR(error, json, ...) do { \
+    PathFilter filter; \
+    for (const char* pointer : {__VA_ARGS__}) { \
+        EXPECT_TRUE(filter.add(pointer)) << pointer; \
+    } \
+    std::string s(json); \
+    ParseError err; \
+    filterEvents(filter, s, err); \
+    EXPECT_EQ(error, err) << s; \
+    filterFileEvents(filter, s, 2, err); \
+    EXPECT_EQ(error, err) << s; \
+} while(false)
+
+static const char* kRecord =
+    " { \"id\" : 7, \"name\" : \"a\\\"]}\", \"tags\" : [ \"x\", [ \"y\" ], { \"z\" : 1 } ],"
+    " \"nested\" : { \"a\" : { \"b\" : [ 1, 2, 3 ] }, \"c\" : \"d\" }, \"a/b\" : 1, \"m~n\" : 2, \"\" : 3 } ";
+
+TEST(json_filter, select)
+{
+    TEST_FILTER("{\"id\":7}", kRecord, "/id");
+    TEST_FILTER("{\"name\":\"a\\\"]}\"}", kRecord, "/name");
+    TEST_FILTER("{\"id\":7,\"nested\":{\"c\":\"d\"}}", kRecord, "/nested/c", "/id");
+    TEST_FILTER("{\"nested\":{\"a\":{\"b\":[1,2,3]}}}", kRecord, "/nested/a/b", "/nested/a/b/1");
+    TEST_FILTER("{\"tags\":[[\"y\"],{\"z\":1}]}", kRecord, "/tags/1", "/tags/2/z");
+    TEST_FILTER("{\"tags\":[\"x\"]}", kRecord, "/tags/0", "/tags/01", "/tags/-", "/tags/9");
+    TEST_FILTER("{\"a/b\":1,\"m~n\":2,\"\":3}", kRecord, "/a~1b", "/m~0n", "/");
+    TEST_FILTER("{\"nested\":{}}", kRecord, "/nested/x", "/id/x");
+    TEST_FILTER("{}", kRecord, "/missing");
+    TEST_FILTER("[[],{\"k\":true}]", "[1, [2], {\"k\":true, \"j\":false}, [3]]", "/1/5", "/2/k");
+    TEST_FILTER("{\"a\":1}", "{\"\\u0061\":1,\"b\":2}", "/a");
+    TEST_FILTER("[]", "[1,2]", "/0/0");//路径经过标量
+    TEST_FILTER("", " 123 ", "/a");
+}
+
+TEST(json_filter, whole_document)
+{
+    const char* samples[] = {
+        "null", " -1.5e10 ", "\"abc\"", "[]", "{}", kRecord, "[null,false,true,123,\"abc\",[1,2,3]]",
+    };
+    for (const char* json : samples) {
+        StringReadStream is(json);
+        StringWriteStream os;
+        Writer<StringWriteStream> writer(os);
+        EXPECT_EQ(PARSE_OK, Reader::parse(is, writer));
+        TEST_FILTER(os.get(), json, "");
+    }
+}
+
+TEST(json_filter, document)
+{
+    PathFilter filter;
+    filter.add("/nested/a");
+    filter.add("/id");
+    std::string json(kRecord);
+    StringReadStream is(json);
+    Document doc;
+    EXPECT_EQ(PARSE_OK, filter.parse(is, doc));
+    ASSERT_TRUE(doc.isObject());
+    EXPECT_EQ(2u, doc.getSize());
+    EXPECT_EQ(7, doc["id"].getInt32());
+    EXPECT_EQ(3, doc["nested"]["a"]["b"][2].getInt32());
+}
+
+TEST(json_filter, skip_untouched)
+{
+    // skipped values are only checked for their structure
+    TEST_FILTER("{\"ok\":1}", "{\"bad\":[\"\\x\", 1e999, tRUE, {\"k\":-}], \"ok\":1}", "/ok");
+}
+
+// a string skipped or scanned as a whole is brought into the window at once, the buffer grows to hold it
+TEST(json_filter, long_string_token)
+{
+    std::string text(1000, 'x');
+    std::string key(300, 'k');
+    std::string json = "{\"skip\":\"" + text + "\",\"" + key + "\":1,\"id\":\"" + text + "\"}";
+    PathFilter filter;
+    filter.add("/id");
+    ParseError err;
+    for (size_t bufferSize : {16, 64, 4096}) {
+        EXPECT_EQ("{\"id\":\"" + text + "\"}", filterFileEvents(filter, json, bufferSize, err)) << bufferSize;
+        EXPECT_EQ(PARSE_OK, err) << bufferSize;
+    }
+}
+
+TEST(json_filter, error)
+{
+    PathFilter filter;
+    EXPECT_FALSE(filter.add("a"));
+    EXPECT_FALSE(filter.add("/a~2"));
+    EXPECT_FALSE(filter.add("/a~"));
+
+    TEST_FILTER_ERROR(PARSE_EXPECT_VALUE, " ", "/a");
+    TEST_FILTER_ERROR(PARSE_ROOT_NOT_SINGULAR, "{} 1", "/a");
+    TEST_FILTER_ERROR(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1, [2}, 3]", "/0");
+    TEST_FILTER_ERROR(PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1 \"b\":2}", "/b");
+    TEST_FILTER_ERROR(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "{\"a\":{\"x\":[1, 2}}", "/b");
+    TEST_FILTER_ERROR(PARSE_MISS_KEY, "{\"a\":1, 2}", "/b");
+    TEST_FILTER_ERROR(PARSE_MISS_COLON, "{\"a\" 1}", "/b");
+    TEST_FILTER_ERROR(PARSE_MISS_QUOTATION_MARK, "{\"a\":\"xyz", "/b");
+    TEST_FILTER_ERROR(PARSE_MISS_QUOTATION_MARK, "{\"a", "/b");
+    TEST_FILTER_ERROR(PARSE_BAD_VALUE, "[1,]", "/1");
+    TEST_FILTER_ERROR(PARSE_BAD_STRING_ESCAPE, "{\"a\":\"\\x\"}", "/a");//选中的值由Reader解析
+    TEST_FILTER_ERROR(PARSE_DEPTH_EXCEEDED, std::string(2000, '[') + std::string(2000, ']'), "/0/0");
+    TEST_FILTER_ERROR(PARSE_DEPTH_EXCEEDED, std::string(2000, '[') + std::string(2000, ']'), "");
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include "cppjson/LazyDocument.hpp"
+#include "cppjson/StringReadStream.hpp"
+#include "cppjson/StringWriteStream.hpp"
+#include "cppjson/Writer.hpp"
+
+using namespace cppjson;
+
+// materializing the root must give the events of Reader::parse
+#define TEST_LAZY_ROUNDTRIP(json) do { \
+    std::string s(json); \
+    StringReadStream is(s); \
+    StringWriteStream expect; \
+    Writer<StringWriteStream> expectWriter(expect); \
+    EXPECT_EQ(PARSE_OK, Reader::parse(is, expectWriter)) << s; \
+    LazyDocument doc; \
+    EXPECT_EQ(PARSE_OK, doc.parse(s)); \
+    StringWriteStream actual; \
+    Writer<StringWriteStream> writer(actual); \
+    EXPECT_EQ(PARSE_OK, doc.root().accept(writer)); \
+    EXPECT_EQ(expect.get(), actual.get()) << s; \
+} while(false)
+
+// navigating to path must throw err
+#define TEST_LAZY_ERROR(err, json, expr) do { \
+    std::string s(json); \
+    LazyDocument doc; \
+    EXPECT_EQ(PARSE_OK, doc.parse(s)); \
+    LazyValue root = doc.root(); \
+    try { \
+        expr; \
+        ADD_FAILURE() << s; \
+    } catch (Exception& e) { \
+        EXPECT_EQ(err, e.getError()) << s; \
+    } \
+} while(false)
+
+TEST(json_lazy, roundtrip)
+{
+    TEST_LAZY_ROUNDTRIP("null");
+    TEST_LAZY_ROUNDTRIP(" -9223372036854775808 ");
+    TEST_LAZY_ROUNDTRIP("\"a\\u0000b\\n\"");
+    TEST_LAZY_ROUNDTRIP("[[],{},[[{}]]]");
+    TEST_LAZY_ROUNDTRIP("{\"n\":null,\"f\":false,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"\":2}}");
+}
+
+TEST(json_lazy, cursor)
+{
+    std::string json =
+        "{ \"n\" : null, \"f\":false, \"i\":-5, \"l\":4294967296, \"d\":0.25, \"s\":\"a\\u0000c\","
+        "\"a\":[1, [2,3] , {\"x\":\"y\"}, 4], \"o\":{}, \"e\\u0073c\":\"\\\"]}\" }";
+    LazyDocument doc;
+    EXPECT_EQ(PARSE_OK, doc.parse(json));
+
+    LazyValue root = doc.root();
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(9u, root.getSize());
+    EXPECT_TRUE(root["n"].isNull());
+    EXPECT_FALSE(root["f"].getBool());
+    EXPECT_EQ(TYPE_INT32, root["i"].getType());
+    EXPECT_EQ(-5, root["i"].getInt32());
+    EXPECT_EQ(-5, root["i"].getInt64());
+    EXPECT_TRUE(root["l"].isInt64());
+    EXPECT_FALSE(root["l"].isInt32());
+    EXPECT_EQ(4294967296LL, root["l"].getInt64());
+    EXPECT_DOUBLE_EQ(0.25, root["d"].getDouble());
+    EXPECT_EQ(std::string("a\0c", 3), root["s"].getString());
+    EXPECT_EQ("\"]}", root["esc"].getString());//键含转义, 字符串中的括号不影响跳过
+    EXPECT_TRUE(root.findMember("missing") == root.getObject().end());
+    EXPECT_EQ(-5, root[std::string("i")].getInt32());//键: a literal, a std::string or a StringRef
+    EXPECT_TRUE(root.findMember(StringRef("dx", 1)) != root.getObject().end());
+    EXPECT_EQ(0u, root["o"].getSize());
+    EXPECT_EQ(-5, root["i"].getInt32());//在提示位置之前
+    EXPECT_EQ(std::string("[1, [2,3] , {\"x\":\"y\"}, 4]"), std::string(root["a"].getRaw(), root["a"].getRawLength()));
+
+    LazyValue a = root["a"];
+    ASSERT_TRUE(a.isArray());
+    EXPECT_EQ(4u, a.getSize());
+    EXPECT_EQ(1, a[0].getInt32());
+    EXPECT_EQ(3, a[1][1].getInt32());
+    EXPECT_EQ("y", a[2]["x"].getString());
+    EXPECT_EQ(4, a[3].getInt32());
+
+    int32_t sum = 0;
+    for (auto& element : a[1].getArray()) {
+        sum += element.getInt32();
+    }
+    EXPECT_EQ(5, sum);
+
+    std::string keys;
+    for (auto& member : root.getObject()) {
+        keys += member.m_key.getString();
+    }
+    EXPECT_EQ("nfildsaoesc", keys);
+}
+
+TEST(json_lazy, skip_untouched)
+{
+    // values that are only skipped are not decoded, their bad escapes and numbers go unnoticed
+    std::string json = "{\"bad\":[\"\\x\", 1e999, {\"k\":-}], \"ok\":1}";
+    LazyDocument doc;
+    EXPECT_EQ(PARSE_OK, doc.parse(json));
+    EXPECT_EQ(1, doc.root()["ok"].getInt32());
+}
+
+TEST(json_lazy, error)
+{
+    LazyDocument doc;
+    EXPECT_EQ(PARSE_EXPECT_VALUE, doc.parse(" \n", 2));
+
+    TEST_LAZY_ERROR(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1 2]", root.getSize());
+    TEST_LAZY_ERROR(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1,[2}]", root.getSize());
+    TEST_LAZY_ERROR(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1", root.getSize());
+    TEST_LAZY_ERROR(PARSE_BAD_VALUE, "[1,]", root.getSize());
+    TEST_LAZY_ERROR(PARSE_BAD_VALUE, "[1x]", root[0].getInt32());
+    TEST_LAZY_ERROR(PARSE_MISS_KEY, "{1:2}", root.getSize());
+    TEST_LAZY_ERROR(PARSE_MISS_COLON, "{\"a\" 2}", root.getSize());
+    TEST_LAZY_ERROR(PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":2 \"b\":3}", root.findMember("b"));
+    TEST_LAZY_ERROR(PARSE_MISS_QUOTATION_MARK, "[\"abc", root.getSize());
+    TEST_LAZY_ERROR(PARSE_BAD_STRING_ESCAPE, "[\"\\x\"]", root[0].getString());
+    TEST_LAZY_ERROR(PARSE_NUMBER_TOO_BIG, "[1e309]", root[0].getDouble());
+
+    // accept() reports errors instead of throwing
+    std::string json = "{\"a\":[1,]}";
+    EXPECT_EQ(PARSE_OK, doc.parse(json));
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    EXPECT_EQ(PARSE_BAD_VALUE, doc.root().accept(writer));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include "cppjson/Document.hpp"
+#include "cppjson/NdjsonReader.hpp"
+#include "cppjson/TapeDocument.hpp"
+#include "cppjson/StringWriteStream.hpp"
+#include "cppjson/Writer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+
+using namespace cppjson;
+
+// line i (from 1) holds {"i":i,...}, every 7th line is broken and every 5th is blank
+static std::string makeLines(size_t lines, std::vector<std::pair<size_t, ParseError>>& expect) {
+    std::string json;
+    for (size_t i = 1; i <= lines; i++) {
+        if (i % 7 == 0) {
+            json += "{\"i\":" + std::to_string(i) + ",}";
+            expect.emplace_back(i, PARSE_MISS_KEY);
+        } else if (i % 5 == 0) {
+            json += i % 10 == 0 ? " \t\r" : "";
+        } else {
+            json += "{\"i\":" + std::to_string(i) + ",\"s\":\"a\\nb\",\"a\":[1,2,3]}";
+            json += i % 3 == 0 ? "\r" : "";
+            expect.emplace_back(i, PARSE_OK);
+        }
+        json += "\n";
+    }
+    json += "[1]";//最后一行没有换行符
+    expect.emplace_back(lines + 1, PARSE_OK);
+    return json;
+}
+
+TEST(json_ndjson, split)
+{
+    std::string json = "1\n22\n\n333\n4444";
+    for (size_t batchSize = 1; batchSize <= json.size() + 1; batchSize++) {
+        std::vector<LineBatch> batches = splitLines(json.data(), json.size(), batchSize);
+        std::string joined;
+        std::vector<size_t> lines;
+        for (auto& batch : batches) {
+            EXPECT_TRUE(batch.m_end == json.data() + json.size() || batch.m_end[-1] == '\n');
+            joined.append(batch.m_begin, batch.m_end);
+            forEachLine(batch, [&](size_t line, const char* p, size_t len) {
+                EXPECT_EQ(std::to_string(line == 1 ? 1 : line == 2 ? 22 : line == 4 ? 333 : 4444), std::string(p, len));
+                lines.push_back(line);
+            });
+        }
+        EXPECT_EQ(json, joined);
+        EXPECT_EQ(std::vector<size_t>({1, 2, 4, 5}), lines);
+    }
+    EXPECT_TRUE(splitLines("", 0, 16).empty());
+}
+
+TEST(json_ndjson, ordered)
+{
+    std::vector<std::pair<size_t, ParseError>> expect;
+    std::string json = makeLines(1000, expect);
+    for (size_t threads : {1, 2, 4}) {
+        for (size_t batchSize : {1, 100, 4096, 1 << 20}) {
+            NdjsonReader<Document> reader(threads, batchSize);
+            EXPECT_EQ(threads, reader.getThreadCount());
+            for (int round = 0; round < 2; round++) {//Docs are reused
+                std::vector<std::pair<size_t, ParseError>> actual;
+                reader.parse(json.data(), json.size(), [&](size_t line, ParseError err, Document& doc) {
+                    actual.emplace_back(line, err);
+                    if (err == PARSE_OK && doc.isObject()) {
+                        EXPECT_EQ(static_cast<int32_t>(line), doc["i"].getInt32());
+                        EXPECT_EQ("a\nb", doc["s"].getString());
+                    }
+                });
+                EXPECT_EQ(expect, actual) << threads << " threads, batch " << batchSize;
+            }
+        }
+    }
+}
+
+// counts the Docs a reader keeps
+struct CountedDocument : Document {
+    static std::atomic<size_t> s_count;
+    CountedDocument() { s_count++; }
+    ~CountedDocument() { s_count--; }
+};
+
+std::atomic<size_t> CountedDocument::s_count(0);
+
+TEST(json_ndjson, ordered_window)
+{
+    std::vector<std::pair<size_t, ParseError>> expect;
+    std::string json = makeLines(1000, expect);
+    for (size_t threads : {1, 3}) {
+        NdjsonReader<CountedDocument> reader(threads);//一个batch装下全部的行
+        std::vector<std::pair<size_t, ParseError>> actual;
+        reader.parse(json.data(), json.size(), [&](size_t line, ParseError err, CountedDocument&) {
+            actual.emplace_back(line, err);
+        });
+        EXPECT_EQ(expect, actual);
+        EXPECT_LE(CountedDocument::s_count.load(), threads * NdjsonReader<CountedDocument>::kWindow);
+    }
+}
+
+TEST(json_ndjson, unordered)
+{
+    std::vector<std::pair<size_t, ParseError>> expect;
+    std::string json = makeLines(1000, expect);
+    NdjsonReader<TapeDocument> reader(4, 512);
+    std::mutex mutex;
+    std::vector<std::pair<size_t, ParseError>> actual;
+    reader.parse(json.data(), json.size(), [&](size_t line, ParseError err, TapeDocument& doc) {
+        std::lock_guard<std::mutex> lock(mutex);
+        actual.emplace_back(line, err);
+        if (err == PARSE_OK && doc.root().isObject()) {
+            EXPECT_EQ(static_cast<int32_t>(line), doc.root()["i"].getInt32());
+        }
+    }, false);
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(expect, actual);
+}
+
+TEST(json_ndjson, callback_throws)
+{
+    std::vector<std::pair<size_t, ParseError>> expect;
+    std::string json = makeLines(1000, expect);
+    NdjsonReader<TapeDocument> reader(3, 64);
+    size_t calls = 0;
+    EXPECT_THROW(reader.parse(json.data(), json.size(), [&](size_t line, ParseError, TapeDocument&) {
+        calls++;
+        if (line == 501) {
+            throw std::runtime_error("stop");
+        }
+    }), std::runtime_error);
+    EXPECT_LT(calls, expect.size());
+
+    // the reader is still usable
+    calls = 0;
+    reader.parse(json.data(), json.size(), [&](size_t, ParseError, TapeDocument&) { calls++; });
+    EXPECT_EQ(expect.size(), calls);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
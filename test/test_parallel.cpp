@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include "cppjson/Document.hpp"
+#include "cppjson/ParallelArrayReader.hpp"
+#include "cppjson/StringWriteStream.hpp"
+#include "cppjson/Writer.hpp"
+
+using namespace cppjson;
+
+static std::string write(Value& value) {
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    writer.fromValue(value);
+    return os.get();
+}
+
+// the parallel result (and error) must be the one of Document::parse
+#define TEST_PARALLEL(reader, json) do { \
+    std::string s(json); \
+    Document expect; \
+    ParseError expectErr = expect.parse(s); \
+    Document doc; \
+    EXPECT_EQ(expectErr, reader.parse(s.data(), s.size(), doc)) << s; \
+    if (expectErr == PARSE_OK) { \
+        EXPECT_EQ(write(expect), write(doc)) << s; \
+    } \
+} while(false)
+
+static std::string makeArray(size_t elements) {
+    std::string json = " [ ";
+    for (size_t i = 0; i < elements; i++) {
+        json += i ? " ,\n" : "";
+        switch (i % 4) {
+            case 0: json += "{\"i\":" + std::to_string(i) + ",\"s\":\"],[{\\\"\",\"a\":[[],{}]}"; break;
+            case 1: json += std::to_string(i); break;
+            case 2: json += "\"" + std::to_string(i) + "\""; break;
+            default: json += "[" + std::to_string(i) + ", null]"; break;
+        }
+    }
+    return json + " ] ";
+}
+
+TEST(json_parallel, array)
+{
+    std::string json = makeArray(1000);
+    for (size_t threads : {1, 3}) {
+        for (size_t batchSize : {1, 50, 4096, 1 << 20}) {
+            ParallelArrayReader reader(threads, batchSize);
+            TEST_PARALLEL(reader, json);
+            TEST_PARALLEL(reader, "[]");
+            TEST_PARALLEL(reader, " [ 1 ] ");
+            TEST_PARALLEL(reader, "[[1,2],[3]]");
+        }
+    }
+
+    ParallelArrayReader reader(2, 100);
+    Document doc;
+    EXPECT_EQ(PARSE_OK, reader.parse(json.data(), json.size(), doc));
+    ASSERT_EQ(1000u, doc.getSize());
+    EXPECT_EQ(996, doc[996]["i"].getInt32());
+    EXPECT_EQ("],[{\"", doc[996]["s"].getString());
+    EXPECT_EQ(997, doc[997].getInt32());
+    EXPECT_EQ("998", doc[998].getString());
+    EXPECT_EQ(999, doc[999][0].getInt32());
+
+    // the copy shares doc's blocks and keeps its MemoryPool, with the pools of the threads it adopted
+    Value copy(doc);
+    EXPECT_EQ(static_cast<const Value&>(copy)[996].getObject().data(), static_cast<const Value&>(doc)[996].getObject().data());
+    EXPECT_EQ(PARSE_OK, reader.parse(json.data(), json.size(), doc));
+    doc.parse("{}");
+    EXPECT_EQ(std::string("],[{\""), copy[996]["s"].getString());
+    Document expect;
+    ASSERT_EQ(PARSE_OK, expect.parse(json));
+    EXPECT_EQ(write(expect), write(copy));
+}
+
+TEST(json_parallel, key_pool)
+{
+    std::string json = "[";
+    for (size_t i = 0; i < 1000; i++) {
+        json += (i ? ",{" : "{") + std::string("\"a_long_record_key\":") + std::to_string(i) + ",\"another_long_key_" + std::to_string(i % 7) + "\":null}";
+    }
+    json += "]";
+    auto keys = std::make_shared<KeyPool>();
+    ParallelArrayReader reader(3, 100);
+    Document doc;
+    doc.setKeyPool(keys);
+    TEST_PARALLEL(reader, json);
+    EXPECT_EQ(PARSE_OK, reader.parse(json.data(), json.size(), doc));
+    EXPECT_EQ(8u, keys->size());
+    EXPECT_EQ(999, doc[999]["a_long_record_key"].getInt32());
+    EXPECT_EQ(doc[0].getObject()[0].m_key.getStringData(), doc[999].getObject()[0].m_key.getStringData());
+    EXPECT_TRUE(doc[13]["another_long_key_6"].isNull());
+}
+
+// the single-threaded fallbacks keep the depth limit of the caller
+TEST(json_parallel, max_depth)
+{
+    ParallelArrayReader reader(2, 1);
+    Document doc;
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, reader.parse("[1,[[[[[[[[[[2]]]]]]]]]],3]", 27, doc, 4));//每个元素都在并行中解析
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, reader.parse("[1,[[[[[[[[[[2]]]]]]]]]],3", 26, doc, 4));//预扫描失败
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, reader.parse("{\"a\":[[[[[1]]]]]}", 17, doc, 4));//不是数组
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, reader.parse("[1]", 3, doc, 0));
+    EXPECT_EQ(PARSE_OK, reader.parse("[1,[[[2]]],3]", 13, doc, 4));
+    EXPECT_EQ(PARSE_OK, reader.parse("{\"a\":[[[1]]]}", 13, doc, 4));
+    EXPECT_EQ(1, doc["a"][0][0][0].getInt32());
+}
+
+TEST(json_parallel, not_array)
+{
+    ParallelArrayReader reader(2, 8);
+    TEST_PARALLEL(reader, "{\"a\":[1,2,3]}");
+    TEST_PARALLEL(reader, " 123 ");
+    TEST_PARALLEL(reader, "\"[\"");
+}
+
+TEST(json_parallel, error)
+{
+    ParallelArrayReader reader(2, 8);
+    const char* samples[] = {
+        "", " ", "[", "[1", "[1,", "[1 2]", "[1,]", "[1,2]]", "[1,2] 3", "[{1:2}, 3]", "[{\"a\" 1}, 3]",
+        "[1, [2}, 3]", "[\"abc", "[\"a\\x\", 1]", "[1, tRUE, 3]", "[1, 2, 1e309]", "[{\"a\":[1}]",
+        "[{1:2, \"a]",
+    };
+    for (const char* json : samples) {
+        TEST_PARALLEL(reader, json);
+    }
+    TEST_PARALLEL(reader, "[" + std::string(1100, '[') + std::string(1100, ']') + "]");
+    TEST_PARALLEL(reader, "[1, " + std::string(1023, '[') + std::string(1023, ']') + "]");
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
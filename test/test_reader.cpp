@@ -0,0 +1,524 @@
+#include <gtest/gtest.h>
+
+#include "cppjson/BufferedFileReadStream.hpp"
+#include "cppjson/Document.hpp"
+#include "cppjson/HandlerAdapter.hpp"
+#include "cppjson/IndexReader.hpp"
+#include "cppjson/MemoryReadStream.hpp"
+#include "cppjson/MmapReadStream.hpp"
+#include "cppjson/PushReader.hpp"
+#include "cppjson/Simd.hpp"
+#include "cppjson/StringReadStream.hpp"
+#include "cppjson/StringWriteStream.hpp"
+#include "cppjson/Writer.hpp"
+
+using namespace cppjson;
+
+// every engine must produce the same events (as written by Writer) and the same error as Reader::parse
+static std::string readerEvents(const std::string& json, ParseError& err) {
+    StringReadStream is(json);
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    err = Reader::parse(is, writer);
+    return os.get();
+}
+
+static std::string indexReaderEvents(const std::string& json, ParseError& err) {
+    IndexReader reader;
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    err = reader.parse(json.data(), json.size(), writer);
+    return os.get();
+}
+
+// the input is fed in chunks of chunkSize bytes, and also split in two at every position
+static std::string pushReaderEvents(const std::string& json, size_t chunkSize, ParseError& err) {
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    PushReader<Writer<StringWriteStream>> reader(writer);
+    for (size_t i = 0; i < json.size(); i += chunkSize) {
+        reader.feed(json.data() + i, std::min(chunkSize, json.size() - i));
+    }
+    err = reader.finish();
+    return os.get();
+}
+
+static std::string pushReaderBytes(const std::string& json, ParseError& err) {
+    return pushReaderEvents(json, 1, err);
+}
+
+static std::string pushReaderSplits(const std::string& json, ParseError& err) {
+    std::string events = pushReaderEvents(json, json.size() + 1, err);
+    for (size_t i = 0; i <= json.size(); i++) {
+        StringWriteStream os;
+        Writer<StringWriteStream> writer(os);
+        PushReader<Writer<StringWriteStream>> reader(writer);
+        reader.feed(json.data(), i);
+        reader.feed(json.data() + i, json.size() - i);
+        EXPECT_EQ(err, reader.finish()) << json << " split at " << i;
+        if (err == PARSE_OK) {
+            EXPECT_EQ(events, os.get()) << json << " split at " << i;
+        }
+    }
+    return events;
+}
+
+static std::string bufferedFileEvents(const std::string& json, size_t bufferSize, ParseError& err) {
+    FILE* fp = tmpfile();
+    fwrite(json.data(), 1, json.size(), fp);
+    rewind(fp);
+    BufferedFileReadStream is(fp, bufferSize);
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    err = Reader::parse(is, writer);
+    fclose(fp);
+    return os.get();
+}
+
+// records whether strings arrive as views into the mapping
+class BorrowCheckWriter : public Writer<StringWriteStream> {
+public:
+    BorrowCheckWriter(StringWriteStream& os, MmapReadStream& is) : Writer<StringWriteStream>(os), m_is(is) {}
+    using Writer<StringWriteStream>::String;
+    using Writer<StringWriteStream>::Key;
+    bool String(const char* s, size_t len, bool copy) override {
+        check(s, len, copy);
+        return Writer<StringWriteStream>::String(s, len, copy);
+    }
+    bool Key(const char* s, size_t len, bool copy) override {
+        check(s, len, copy);
+        return Writer<StringWriteStream>::Key(s, len, copy);
+    }
+    size_t m_views = 0;
+private:
+    void check(const char* s, size_t len, bool copy) {
+        if (!copy) {
+            EXPECT_TRUE(s >= m_is.getBegin() && s + len < m_is.getEnd() && s[len] == '"');
+            m_views++;
+        }
+    }
+    MmapReadStream& m_is;
+};
+
+static size_t g_mmapViews = 0;
+
+static std::string mmapEvents(const std::string& json, ParseError& err) {
+    FILE* fp = tmpfile();
+    fwrite(json.data(), 1, json.size(), fp);
+    fflush(fp);
+    rewind(fp);//从FILE的当前位置开始映射
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    MmapReadStream is(fp);
+    err = Reader::parse(is, writer);
+
+    // with borrowStrings the events are the same, only plain strings come as views
+    StringWriteStream borrowedOs;
+    MmapReadStream borrowedIs(fp, true);
+    BorrowCheckWriter borrowedWriter(borrowedOs, borrowedIs);
+    EXPECT_EQ(err, Reader::parse(borrowedIs, borrowedWriter)) << json;
+    if (err == PARSE_OK) {
+        EXPECT_EQ(os.get(), borrowedOs.get());
+    }
+    g_mmapViews = borrowedWriter.m_views;
+    fclose(fp);
+    return os.get();
+}
+
+// every token and whitespace run is cut by a refill somewhere
+static std::string bufferedFileSmallBuffers(const std::string& json, ParseError& err) {
+    std::string events = bufferedFileEvents(json, 1, err);
+    for (size_t bufferSize : {2, 3, 5, 8, 13}) {
+        ParseError e;
+        EXPECT_EQ(events, bufferedFileEvents(json, bufferSize, e)) << json << " buffer " << bufferSize;
+        EXPECT_EQ(err, e) << json << " buffer " << bufferSize;
+    }
+    return events;
+}
+
+#define TEST_SAME(engine, json) do { \
+    std::string s(json); \
+    ParseError expectErr, err; \
+    std::string expect = readerEvents(s, expectErr); \
+    std::string actual = engine(s, err); \
+    EXPECT_EQ(expectErr, err) << s; \
+    if (expectErr == PARSE_OK) { EXPECT_EQ(expect, actual) << s; } \
+} while(false)
+
+static const char* kSamples[] = {
+    "", " ", " \r\n", "null", " true ", "false", "-0", "123", "-1.5e10", "2147483648", "\"abc\"",
+    "[]", "{}", "[[]]", "[ { } , { } ]", "[null,false,true,123,\"abc\",[1,2,3]]",
+    "{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}",
+    " { \"a\" : [ 1 , \"x,]}\" , { \"b\\\"\" : \"\\\\\" } ] } ",
+    "tRUE", "falss", "nulr", "1.", "001", "10e", "-00", "[null,]", "1.0i32", "1i64", "NaN", "Infinity",
+    "true false", "null f", "1.0.1", "9527 9528", "\"9527\" \"9528\"", "[] []", "{} []",
+    "1e309", "9223372036854775808", "12345678901i32",
+    "\"abcd\1efg\"", "\"xxx\\x\"", "\"\\u123\"", "\"\\ud800\"", "\"wtf", "\"xx\\\"",
+    "[1, 2", "[truefalse]", "[1 2]", "[\"a\"\"b\"]", "[1,", "[", "{", "{:null}", "{\"hehe\":null, }",
+    "{\"hehe\"}", "{\"a\" 1}", "{\"hehe\":null, \"data\"}", "{\"hehe\":false", "{\"hehe\":false, \"\":\"x\"",
+    "{\"a\":1}}", "[1]]", "]", "}", ",", ":", "[:]", "{\"a\"::1}", "{\"a\":1,,}",
+};
+
+TEST(json_reader, index_reader)
+{
+    for (const char* json : kSamples) {
+        TEST_SAME(indexReaderEvents, json);
+    }
+}
+
+TEST(json_reader, push_reader)
+{
+    for (const char* json : kSamples) {
+        TEST_SAME(pushReaderBytes, json);
+        TEST_SAME(pushReaderSplits, json);
+    }
+    const char* more[] = {
+        "\"\\u4e2d\\u6587\\ud834\\udd1e\\n\"", "[\"a\\\\\",\"\\\"\"]", "{\"key\" : [ -1.25e-3 , 1e10 , 12345678901234567890 ]}",
+        "[1x]", "{\"a\":1x}", "1x", "nullx", "[Infinity,-Infinity,NaN]", "[\"\\u12\"34\"]", "\"abc", "\"ab\\",
+        "\"a\tb\"", "[1,]", "[,1]", "{\"a\":}", "{\"a\"", "{\"a\":1", "[1", "[1,", "[\"x\"", " [ ] ", "[1 ,2 ]",
+    };
+    for (const char* json : more) {
+        TEST_SAME(pushReaderBytes, json);
+        TEST_SAME(pushReaderSplits, json);
+    }
+}
+
+TEST(json_reader, push_reader_chunks)
+{
+    std::string json = "[";
+    for (int i = 0; i < 200; i++) {
+        json += "{\"id\":" + std::to_string(i * 7919) + ",\"d\":-" + std::to_string(i) + ".5e-" + std::to_string(i % 30) +
+                ",\"s\":\"x\\u00e9\\\"\\\\y\\ud83d\\ude00" + std::string(i % 70, 'z') + "\",\"b\":[true,false,null]},\n";
+    }
+    json += "{}]";
+    for (size_t chunk = 1; chunk < 100; chunk += 7) {
+        TEST_SAME([chunk](const std::string& s, ParseError& err) { return pushReaderEvents(s, chunk, err); }, json);
+    }
+}
+
+TEST(json_reader, buffered_file)
+{
+    for (const char* json : kSamples) {
+        TEST_SAME(bufferedFileSmallBuffers, json);
+    }
+    const char* more[] = {
+        "\"\\u4e2d\\u6587\\ud834\\udd1e\\n\"", "{\"key\" : [ -1.25e-3 , 1e10 , 12345678901234567890 ]}",
+        "[1x]", "1x", "[Infinity,-Infinity,NaN]", "\"abc", "\"ab\\", "[1 ,2 ]", "[1.5e", "-", "[-1.5e+300  ,  4.9e-324]",
+        "    \r\n\t    [      \"     \\\\   \"    ]       ",
+    };
+    for (const char* json : more) {
+        TEST_SAME(bufferedFileSmallBuffers, json);
+    }
+
+    // a number longer than the buffer
+    std::string digits = "[0." + std::string(300, '1') + "e-5, 1" + std::string(250, '0') + "]";
+    ParseError err;
+    std::string events = bufferedFileEvents(digits, 4096, err);
+    for (size_t bufferSize : {1, 7, 64, 100}) {
+        ParseError e;
+        EXPECT_EQ(events, bufferedFileEvents(digits, bufferSize, e));
+        EXPECT_EQ(err, e);
+    }
+}
+
+TEST(json_reader, mmap)
+{
+    for (const char* json : kSamples) {
+        TEST_SAME(mmapEvents, json);
+    }
+    TEST_SAME(mmapEvents, "{\"plain\":\"view\",\"esc\\n\":[\"a\\u0041\",\"\",\"x\"]}");
+    EXPECT_EQ(4u, g_mmapViews);//"plain", "view", "" and "x"
+}
+
+TEST(json_reader, push_reader_state)
+{
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    PushReader<Writer<StringWriteStream>> reader(writer);
+
+    // events are emitted as soon as the tokens are complete
+    EXPECT_EQ(PARSE_OK, reader.feed("[tr", 3));
+    EXPECT_EQ("[", os.get());
+    EXPECT_EQ(PARSE_OK, reader.feed("ue,\"a", 5));
+    EXPECT_EQ("[true", os.get());
+    EXPECT_EQ(PARSE_OK, reader.feed("b\"]", 3));
+    EXPECT_EQ("[true,\"ab\"]", os.get());
+    EXPECT_EQ(PARSE_OK, reader.finish());
+
+    // the first error sticks
+    reader.reset();
+    EXPECT_EQ(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, reader.feed(" [1 2", 5));
+    EXPECT_EQ(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, reader.feed("]", 1));
+    EXPECT_EQ(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, reader.finish());
+
+    reader.reset();
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, PushReader<Writer<StringWriteStream>>(writer, 1).feed("[[", 2));
+}
+
+TEST(json_reader, index_reader_blocks)
+{
+    // strings, escapes and backslash runs straddling the 64-byte blocks of stage 1
+    for (size_t n = 0; n < 140; n++) {
+        std::string pad(n, ' ');
+        std::string x(n, 'x');
+        TEST_SAME(indexReaderEvents, pad + "[\"" + x + "\\\\\",\"" + x + "\\\"]\"," + std::to_string(n) + "]");
+        TEST_SAME(indexReaderEvents, "{\"" + x + "\":[\"\\\\\\\\\\\"" + x + "{\"]," + pad + "\"k\":" + pad + "true}");
+        TEST_SAME(indexReaderEvents, pad + "[\"" + x + "\\\\\\\"\"" + pad + "]");
+        TEST_SAME(indexReaderEvents, "[\"" + x + "\\\"" + pad);
+        TEST_SAME(indexReaderEvents, pad + "1" + x + pad);
+    }
+}
+
+TEST(json_reader, index_reader_chunks)
+{
+    // tokens straddling the chunks stage 1 indexes ahead of stage 2
+    for (size_t n = 16 * 1024 - 70; n < 16 * 1024 + 10; n++) {
+        std::string pad(n, ' ');
+        TEST_SAME(indexReaderEvents, "[" + pad + "\"ab\\n\\u00e9\\ud83d\\ude00c\",-1.5e3,true," + pad + "{\"k\":null}]");
+        TEST_SAME(indexReaderEvents, pad + "[\"" + pad + "\\\"\"]");
+        TEST_SAME(indexReaderEvents, pad + "12345678" + pad);
+        TEST_SAME(indexReaderEvents, pad + "[1" + pad);
+    }
+}
+
+static std::vector<uint32_t> structuralIndex(const std::string& json) {
+    StructuralIndexState state = StructuralIndexState();
+    std::vector<uint32_t> index(json.size());
+    index.resize(buildStructuralIndex(json.data(), 0, json.size(), state, index.data()));
+    return index;
+}
+
+TEST(json_reader, index_reader_control_bytes)
+{
+    // 0x0C and 0x1A share their low nibble with ',' and ':', they are not structural
+    std::string pad(64, ' ');
+    for (const std::string& p : {std::string(), pad}) {
+        EXPECT_EQ(std::vector<uint32_t>({0, 1, 3, 4, 6}), structuralIndex("[1\x0c,2\x1a]" + p));
+        // inside a string they are control characters, indexed for stage 2 to reject
+        EXPECT_EQ(std::vector<uint32_t>({0, 1, 2, 3, 6, 7}), structuralIndex("[\"\x0c\x1a a\"]" + p));
+        EXPECT_EQ(std::vector<uint32_t>({0, 1, 2, 5, 6}), structuralIndex("[\"\\f:\"]" + p));
+    }
+    for (const char* json : {"[\"\x0c\"]", "[\"a\x1a\"]", "{\"\x0c\":1}", "[\"\\f\x1a\"]", "[1\x0c]", "[\x1a]",
+                             "{\"a\"\x1a:1}", "[\"\\f\\u001a,\"]", "{\"\\f\":\"\\u000c\"}"}) {
+        TEST_SAME(indexReaderEvents, json);
+        TEST_SAME(indexReaderEvents, std::string(100, ' ') + json);
+    }
+}
+
+TEST(json_reader, index_reader_reuse)
+{
+    IndexReader reader;
+    for (const char* json : kSamples) {
+        StringWriteStream expect;
+        Writer<StringWriteStream> expectWriter(expect);
+        StringReadStream is(json);
+        ParseError expectErr = Reader::parse(is, expectWriter);
+
+        StringWriteStream os;
+        Writer<StringWriteStream> writer(os);
+        EXPECT_EQ(expectErr, reader.parse(json, strlen(json), writer));
+        if (expectErr == PARSE_OK) {
+            EXPECT_EQ(expect.get(), os.get());
+        }
+    }
+}
+
+static ParseError parseWithDepth(const std::string& json, size_t maxDepth, std::string& out) {
+    StringReadStream is(json);
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    ParseError err = Reader::parse(is, writer, maxDepth);
+    out = os.get();
+    return err;
+}
+
+static ParseError indexParseWithDepth(const std::string& json, size_t maxDepth) {
+    IndexReader reader;
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    return reader.parse(json.data(), json.size(), writer, maxDepth);
+}
+
+TEST(json_reader, depth_limit)
+{
+    std::string out;
+    const char* nested = "[{\"a\":[1]},{}]";
+    EXPECT_EQ(PARSE_OK, parseWithDepth(nested, 3, out));
+    EXPECT_EQ(nested, out);
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, parseWithDepth(nested, 2, out));
+    EXPECT_EQ(PARSE_OK, parseWithDepth("[[],{}]", 2, out));
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, parseWithDepth("[[],{}]", 1, out));//空容器也算一层
+    EXPECT_EQ(PARSE_OK, parseWithDepth("123", 0, out));
+
+    EXPECT_EQ(PARSE_OK, indexParseWithDepth(nested, 3));
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, indexParseWithDepth(nested, 2));
+    EXPECT_EQ(PARSE_OK, indexParseWithDepth("[[],{}]", 2));
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, indexParseWithDepth("[[],{}]", 1));
+}
+
+TEST(json_reader, deep_nesting)
+{
+    // far deeper than a recursive parser survives, the stack usage must not depend on the depth
+    const size_t depth = 1000000;
+    std::string json;
+    for (size_t i = 0; i < depth; i++) {
+        json += i % 2 ? "{\"k\":" : "[";
+    }
+    json += "null";
+    for (size_t i = depth; i > 0; i--) {
+        json += (i - 1) % 2 ? "}" : "]";
+    }
+    std::string out;
+    EXPECT_EQ(PARSE_OK, parseWithDepth(json, depth, out));
+    EXPECT_EQ(json, out);
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, parseWithDepth(json, depth - 1, out));
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, parseWithDepth(json, Reader::kDefaultMaxDepth, out));
+    EXPECT_EQ(PARSE_OK, indexParseWithDepth(json, depth));
+    EXPECT_EQ(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, parseWithDepth(json.substr(0, json.size() - 1) + "}", depth, out));
+}
+
+// the grammar follows the flags, a small BufferedFileReadStream window must not change the result
+template <unsigned parseFlags>
+static ParseError parseWithFlags(const std::string& json, std::string& out) {
+    StringReadStream is(json);
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    ParseError err = Reader::parse<parseFlags>(is, writer);
+    out = os.get();
+
+    FILE* fp = tmpfile();
+    fwrite(json.data(), 1, json.size(), fp);
+    rewind(fp);
+    BufferedFileReadStream file(fp, 3);
+    StringWriteStream fileOs;
+    Writer<StringWriteStream> fileWriter(fileOs);
+    EXPECT_EQ(err, Reader::parse<parseFlags>(file, fileWriter)) << json;
+    if (err == PARSE_OK) {
+        EXPECT_EQ(out, fileOs.get()) << json;
+    }
+    fclose(fp);
+    return err;
+}
+
+TEST(json_reader, flags)
+{
+    std::string out;
+    EXPECT_EQ(PARSE_OK, parseWithFlags<kParseDefault>("[NaN, Infinity, 1i32, 2i64]", out));
+    EXPECT_EQ(PARSE_BAD_VALUE, parseWithFlags<kParseStrict>("NaN", out));
+    EXPECT_EQ(PARSE_BAD_VALUE, parseWithFlags<kParseStrict>("[Infinity]", out));
+    EXPECT_EQ(PARSE_ROOT_NOT_SINGULAR, parseWithFlags<kParseStrict>("1i32", out));
+    EXPECT_EQ(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, parseWithFlags<kParseStrict>("[1i64]", out));
+    EXPECT_EQ(PARSE_OK, parseWithFlags<kParseNanInf>("[NaN]", out));
+    EXPECT_EQ(PARSE_ROOT_NOT_SINGULAR, parseWithFlags<kParseNanInf>("1i32", out));
+    EXPECT_EQ(PARSE_OK, parseWithFlags<kParseStrict>("[1, 2.5e3, \"s\", {\"a\":null}]", out));
+    EXPECT_EQ("[1,2500.0,\"s\",{\"a\":null}]", out);
+
+    // comments
+    EXPECT_EQ(PARSE_BAD_VALUE, parseWithFlags<kParseDefault>("/**/ 1", out));
+    EXPECT_EQ(PARSE_OK, parseWithFlags<kParseComments>("/* a ** b */ [1, // x ]\n 2 /* ] */ ]// end", out));
+    EXPECT_EQ("[1,2]", out);
+    EXPECT_EQ(PARSE_OK, parseWithFlags<kParseComments>("{\"a\"/**/:/**/1/**/}", out));
+    EXPECT_EQ("{\"a\":1}", out);
+    EXPECT_EQ(PARSE_OK, parseWithFlags<kParseComments>("\"/* not a comment */\"", out));
+    EXPECT_EQ("\"/* not a comment */\"", out);
+    EXPECT_EQ(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, parseWithFlags<kParseComments>("[1 /x]", out));
+    EXPECT_EQ(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, parseWithFlags<kParseComments>("[1 /* x ]", out));
+    EXPECT_EQ(PARSE_EXPECT_VALUE, parseWithFlags<kParseComments>("// only", out));
+
+    // trailing commas
+    EXPECT_EQ(PARSE_BAD_VALUE, parseWithFlags<kParseDefault>("[1,]", out));
+    EXPECT_EQ(PARSE_MISS_KEY, parseWithFlags<kParseDefault>("{\"a\":1,}", out));
+    EXPECT_EQ(PARSE_OK, parseWithFlags<kParseTrailingCommas>("[1, [2,], {\"a\":1 , } ,\n]", out));
+    EXPECT_EQ("[1,[2],{\"a\":1}]", out);
+    EXPECT_EQ(PARSE_BAD_VALUE, parseWithFlags<kParseTrailingCommas>("[1,,]", out));
+    EXPECT_EQ(PARSE_BAD_VALUE, parseWithFlags<kParseTrailingCommas>("[,]", out));
+    EXPECT_EQ(PARSE_MISS_KEY, parseWithFlags<kParseTrailingCommas>("{,}", out));
+    EXPECT_EQ(PARSE_OK, parseWithFlags<kParseComments | kParseTrailingCommas>("[1, /* c */ ]", out));
+    EXPECT_EQ("[1]", out);
+
+    // UTF-8
+    const char* valid[] = {
+        "\"h\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\"", "\"\xED\x9F\xBF\xEE\x80\x80\xF4\x8F\xBF\xBF\"",
+        "\"\\uD83D\\uDE00\"", "{\"\xC3\xA9\":1}",
+    };
+    for (const char* json : valid) {
+        EXPECT_EQ(PARSE_OK, parseWithFlags<kParseValidateUtf8>(json, out)) << json;
+    }
+    const char* invalid[] = {
+        "\"\xC3\"", "\"\xC3(\"", "\"\xC0\x80\"", "\"\xE0\x9F\xBF\"", "\"\xED\xA0\x80\"", "\"\xF0\x8F\xBF\xBF\"",
+        "\"\xF4\x90\x80\x80\"", "\"\xFF\"", "\"\x80\"", "\"\\uDC00\"", "{\"\xC3\":1}", "[\"a\", \"b\xE2\x82\"]",
+    };
+    for (const char* json : invalid) {
+        EXPECT_EQ(PARSE_BAD_UTF8, parseWithFlags<kParseValidateUtf8>(json, out)) << json;
+        EXPECT_EQ(PARSE_OK, parseWithFlags<kParseDefault>(json, out)) << json;
+    }
+    std::string insitu = "[\"ok\", \"\xC3\"]";
+    InsituStringStream is(&insitu[0], insitu.size());
+    Document doc;
+    EXPECT_EQ(PARSE_BAD_UTF8, doc.parseStream<kParseValidateUtf8>(is));
+}
+
+// String/Key as (const char*, size_t, bool copy): a plain string is a view into the input, an escaped one is decoded
+struct ViewRecorder {
+    const char* m_begin;
+    const char* m_end;
+    std::vector<std::string> m_strings;
+    std::vector<bool> m_intoInput;
+    bool record(const char* s, size_t len, bool copy) {
+        EXPECT_TRUE(copy);
+        m_strings.emplace_back(s, len);
+        m_intoInput.push_back(s >= m_begin && s + len <= m_end);
+        return true;
+    }
+    bool Null() { return true; }
+    bool Bool(bool) { return true; }
+    bool Int32(int32_t) { return true; }
+    bool Int64(int64_t) { return true; }
+    bool Double(double) { return true; }
+    bool String(const char* s, size_t len, bool copy) { return record(s, len, copy); }
+    bool Key(const char* s, size_t len, bool copy) { return record(s, len, copy); }
+    bool StartArray() { return true; }
+    bool EndArray() { return true; }
+    bool StartObject() { return true; }
+    bool EndObject() { return true; }
+};
+
+// a handler written against std::string
+struct LegacyHandler {
+    std::vector<std::string> m_strings;
+    bool Null() { return true; }
+    bool Bool(bool) { return true; }
+    bool Int32(int32_t) { return true; }
+    bool Int64(int64_t) { return true; }
+    bool Double(double) { return true; }
+    bool String(std::string s) { m_strings.push_back(std::move(s)); return true; }
+    bool Key(std::string s) { m_strings.push_back("key " + s); return true; }
+    bool StartArray() { return true; }
+    bool EndArray() { return true; }
+    bool StartObject() { return true; }
+    bool EndObject() { return true; }
+};
+
+TEST(json_reader, string_views)
+{
+    std::string json = "{\"plain\":[\"x\", \"a\\nb\", \"\"], \"k\\\"\":1}";
+    std::vector<std::string> expect = {"plain", "x", "a\nb", "", "k\""};
+
+    MemoryReadStream is(json.data(), json.size());
+    ViewRecorder recorder{json.data(), json.data() + json.size(), {}, {}};
+    EXPECT_EQ(PARSE_OK, Reader::parse(is, recorder));
+    EXPECT_EQ(expect, recorder.m_strings);
+    EXPECT_EQ(std::vector<bool>({true, true, false, true, false}), recorder.m_intoInput);
+
+    StringReadStream stringIs(json);
+    LegacyHandler legacy;
+    StringHandlerAdapter<LegacyHandler> adapter(legacy);
+    EXPECT_EQ(PARSE_OK, Reader::parse(stringIs, adapter));
+    EXPECT_EQ(std::vector<std::string>({"key plain", "x", "a\nb", "", "key k\""}), legacy.m_strings);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
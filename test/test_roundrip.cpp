@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
 #include "cppjson/Document.hpp"
+#include "cppjson/MemoryReadStream.hpp"
+#include "cppjson/PrettyWriter.hpp"
 #include "cppjson/Writer.hpp"
 #include "cppjson/StringWriteStream.hpp"
 
@@ -30,11 +32,10 @@ TEST(json_round, number)
 /* https://en.wikipedia.org/wiki/Double-precision_floating-point_format */
     TEST_ROUNDTRIP("1.0000000000000002");
     TEST_ROUNDTRIP("-1.0000000000000002");
-    // fixme: stod has bug...
-//    TEST_ROUNDTRIP("4.9406564584124654e-324");
-//    TEST_ROUNDTRIP("-4.9406564584124654e-324");
-//    TEST_ROUNDTRIP("2.2250738585072009e-308");
-//    TEST_ROUNDTRIP("-2.2250738585072009e-308");
+    TEST_ROUNDTRIP("4.9406564584124654e-324");
+    TEST_ROUNDTRIP("-4.9406564584124654e-324");
+    TEST_ROUNDTRIP("2.2250738585072009e-308");
+    TEST_ROUNDTRIP("-2.2250738585072009e-308");
     TEST_ROUNDTRIP("2.2250738585072014e-308");
     TEST_ROUNDTRIP("-2.2250738585072014e-308");
     TEST_ROUNDTRIP("1.7976931348623157e+308");
@@ -63,6 +64,120 @@ TEST(json_round, object)
     TEST_ROUNDTRIP("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
 }
 
+// kParseRawNumbers: numbers are written back as they were read, not reformatted
+#define TEST_RAW_ROUNDTRIP(json) do { \
+    std::string s(json); \
+    MemoryReadStream is(s.data(), s.size()); \
+    Document doc; \
+    EXPECT_EQ(PARSE_OK, doc.parseStream<kParseDefault | kParseRawNumbers>(is)); \
+    StringWriteStream os; \
+    Writer<StringWriteStream> writer(os); \
+    writer.fromValue(doc); \
+    EXPECT_EQ(s, os.get()); \
+    Document copy; \
+    static_cast<Value&>(copy) = doc; \
+    StringWriteStream copyOs; \
+    Writer<StringWriteStream> copyWriter(copyOs); \
+    copyWriter.fromValue(copy); \
+    EXPECT_EQ(s, copyOs.get()); \
+} while(false)
+
+TEST(json_round, raw_number)
+{
+    TEST_ROUNDTRIP("[0.5,1.0]");
+    TEST_RAW_ROUNDTRIP("0.10");
+    TEST_RAW_ROUNDTRIP("-0");
+    TEST_RAW_ROUNDTRIP("[1E+2,0.1000000000000000055511151231257827,1e309,3i32,-7i64]");
+    TEST_RAW_ROUNDTRIP("{\"id\":123456789012345678,\"ts\":1700000000000,\"v\":[1.50,2e-3]}");
+
+    std::string json = "[0.10, -0, 2147483647, 2147483648, -2147483648, -2147483649, 1.5e-7, 12345678901234567890e-3, "
+                       "-1e309, 5i64, 1e3]";
+    MemoryReadStream is(json.data(), json.size());
+    Document doc;
+    ASSERT_EQ(PARSE_OK, doc.parseStream<kParseDefault | kParseRawNumbers>(is));
+    EXPECT_TRUE(doc[0].isRawNumber());
+    EXPECT_EQ("0.10", std::string(doc[0].getRawNumberData(), doc[0].getRawNumberLength()));
+    EXPECT_EQ(TYPE_DOUBLE, doc[0].getType());
+    EXPECT_EQ(0.1, doc[0].getDouble());
+    EXPECT_EQ(TYPE_INT32, doc[1].getType());
+    EXPECT_EQ(0, doc[1].getInt32());
+    EXPECT_EQ(TYPE_INT32, doc[2].getType());
+    EXPECT_EQ(2147483647, doc[2].getInt32());
+    EXPECT_EQ(TYPE_INT64, doc[3].getType());
+    EXPECT_EQ(2147483648LL, doc[3].getInt64());
+    EXPECT_EQ(TYPE_INT32, doc[4].getType());
+    EXPECT_EQ(-2147483647 - 1, doc[4].getInt32());
+    EXPECT_EQ(TYPE_INT64, doc[5].getType());
+    EXPECT_EQ(-2147483649LL, doc[5].getInt64());
+    EXPECT_EQ(1.5e-7, doc[6].getDouble());
+    EXPECT_EQ(12345678901234567.890, doc[7].getDouble());
+    EXPECT_EQ(-HUGE_VAL, doc[8].getDouble());
+    Document eager;
+    EXPECT_EQ(PARSE_NUMBER_TOO_BIG, eager.parse("-1e309"));//不是原文模式时超出范围是错误
+    EXPECT_EQ(TYPE_INT64, doc[9].getType());
+    EXPECT_EQ(5, doc[9].getInt64());
+    EXPECT_EQ(1000.0, doc[10].getDouble());
+
+    // setting a value drops the text
+    doc[10].setDouble(2.5);
+    EXPECT_FALSE(doc[10].isRawNumber());
+
+    StringWriteStream os;
+    PrettyWriter<StringWriteStream> writer(os, " ");
+    writer.fromValue(doc[0]);
+    EXPECT_EQ("0.10", os.get());
+
+    // integers out of range fail as before
+    for (const char* bad : {"9223372036854775808", "-9223372036854775809", "2147483648i32", "123456789012345678901"}) {
+        MemoryReadStream badIs(bad, strlen(bad));
+        EXPECT_EQ(PARSE_NUMBER_TOO_BIG, doc.parseStream<kParseDefault | kParseRawNumbers>(badIs)) << bad;
+    }
+}
+
+// the value converted on the first read is kept beside the text, later reads, copies and the Writer see the same number
+TEST(json_round, raw_number_cache)
+{
+    std::string json = "[7,-0.25,1234567,-9876543210,0.1000000000000000055511151231257827,3i32,1e309]";
+    MemoryReadStream is(json.data(), json.size());
+    Document doc;
+    ASSERT_EQ(PARSE_OK, doc.parseStream<kParseDefault | kParseRawNumbers>(is));
+    for (int round = 0; round < 2; round++) {
+        EXPECT_EQ(7, doc[0].getInt32());
+        EXPECT_EQ(-0.25, doc[1].getDouble());
+        EXPECT_EQ(1234567, doc[2].getInt64());
+        EXPECT_EQ(-9876543210LL, doc[3].getInt64());
+        EXPECT_EQ(0.1, doc[4].getDouble());
+        EXPECT_EQ(3, doc[5].getInt32());
+        EXPECT_EQ(HUGE_VAL, doc[6].getDouble());
+    }
+    StringWriteStream os;
+    Writer<StringWriteStream> writer(os);
+    writer.fromValue(doc);
+    EXPECT_EQ(json, os.get());
+
+    // the copy leaves the pool with the cached value, copies of the copy share the text
+    Value copy = doc;
+    Value shared = copy;
+    EXPECT_EQ(-9876543210LL, copy[3].getInt64());
+    EXPECT_EQ(0.1, shared[4].getDouble());
+    EXPECT_EQ(7, shared[0].getInt32());
+    EXPECT_EQ("-9876543210", std::string(shared[3].getRawNumberData(), shared[3].getRawNumberLength()));
+
+    // on the heap, and borrowed (no slot: converted on every read)
+    std::string text = "12345678901";
+    Value heap, borrowed;
+    heap.setRawNumber(text.data(), text.size());
+    borrowed.setRawNumber(text.data(), text.size(), false);
+    EXPECT_EQ(12345678901LL, heap.getInt64());
+    EXPECT_EQ(12345678901LL, borrowed.getInt64());
+    text[0] = '9';
+    EXPECT_EQ(12345678901LL, heap.getInt64());
+    EXPECT_EQ(92345678901LL, borrowed.getInt64());
+    const Value constCopy = heap;
+    EXPECT_EQ(12345678901LL, constCopy.getInt64());
+    EXPECT_EQ(11u, constCopy.getRawNumberLength());
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
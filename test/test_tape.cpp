@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include "cppjson/TapeDocument.hpp"
+#include "cppjson/StringReadStream.hpp"
+#include "cppjson/StringWriteStream.hpp"
+#include "cppjson/Writer.hpp"
+
+using namespace cppjson;
+
+// TapeDocument must reproduce the events of Reader::parse, and fail the same way
+#define TEST_TAPE_ROUNDTRIP(json) do { \
+    std::string s(json); \
+    StringReadStream is(s); \
+    StringWriteStream expect; \
+    Writer<StringWriteStream> expectWriter(expect); \
+    ParseError expectErr = Reader::parse(is, expectWriter); \
+    TapeDocument doc; \
+    EXPECT_EQ(expectErr, doc.parse(s)) << s; \
+    if (expectErr == PARSE_OK) { \
+        StringWriteStream actual; \
+        Writer<StringWriteStream> writer(actual); \
+        EXPECT_TRUE(doc.root().accept(writer)); \
+        EXPECT_EQ(expect.get(), actual.get()) << s; \
+    } else { \
+        EXPECT_EQ(0u, doc.getTapeSize()); \
+    } \
+} while(false)
+
+TEST(json_tape, roundtrip)
+{
+    TEST_TAPE_ROUNDTRIP("null");
+    TEST_TAPE_ROUNDTRIP("true");
+    TEST_TAPE_ROUNDTRIP("-2147483648");
+    TEST_TAPE_ROUNDTRIP("9223372036854775807");
+    TEST_TAPE_ROUNDTRIP("-9223372036854775808");
+    TEST_TAPE_ROUNDTRIP("1.5e-300");
+    TEST_TAPE_ROUNDTRIP("\"\"");
+    TEST_TAPE_ROUNDTRIP("\"a\\u0000b\\n\"");
+    TEST_TAPE_ROUNDTRIP("[]");
+    TEST_TAPE_ROUNDTRIP("{}");
+    TEST_TAPE_ROUNDTRIP("[[],{},[[{}]]]");
+    TEST_TAPE_ROUNDTRIP("[null,false,true,123,1i64,-1.5,\"abc\",[1,2,3]]");
+    TEST_TAPE_ROUNDTRIP("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"\":2}}");
+    TEST_TAPE_ROUNDTRIP("[1, 2");
+    TEST_TAPE_ROUNDTRIP("{\"a\":1}}");
+    TEST_TAPE_ROUNDTRIP("[\"abc\", 1e309]");
+}
+
+TEST(json_tape, cursor)
+{
+    TapeDocument doc;
+    EXPECT_EQ(PARSE_OK, doc.parse(
+        "{\"n\":null,\"f\":false,\"i\":-5,\"l\":4294967296,\"d\":0.25,\"s\":\"a\\u0000c\","
+        "\"a\":[1,[2,3],{\"x\":\"y\"},4],\"o\":{}}"));
+
+    TapeValue root = doc.root();
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(8u, root.getSize());
+    EXPECT_TRUE(root["n"].isNull());
+    EXPECT_FALSE(root["f"].getBool());
+    EXPECT_EQ(-5, root["i"].getInt32());
+    EXPECT_EQ(-5, root["i"].getInt64());
+    EXPECT_TRUE(root["l"].isInt64());
+    EXPECT_FALSE(root["l"].isInt32());
+    EXPECT_EQ(4294967296LL, root["l"].getInt64());
+    EXPECT_DOUBLE_EQ(0.25, root["d"].getDouble());
+    EXPECT_EQ(std::string("a\0c", 3), root["s"].getString());
+    EXPECT_EQ(3u, root["s"].getStringLength());
+    EXPECT_EQ('\0', root["s"].getStringData()[3]);
+    EXPECT_TRUE(root.findMember("missing") == root.getObject().end());
+    EXPECT_EQ(-5, root[std::string("i")].getInt32());//键: a literal, a std::string or a StringRef
+    EXPECT_TRUE(root.findMember(StringRef("dx", 1)) != root.getObject().end());
+    EXPECT_TRUE(root.findMember("o") != root.getObject().end());
+    EXPECT_EQ(0u, root["o"].getSize());
+
+    TapeValue a = root["a"];
+    ASSERT_TRUE(a.isArray());
+    EXPECT_EQ(4u, a.getSize());
+    EXPECT_EQ(1, a[0].getInt32());
+    EXPECT_EQ(3, a[1][1].getInt32());
+    EXPECT_EQ("y", a[2]["x"].getString());
+    EXPECT_EQ(4, a[3].getInt32());
+
+    int32_t sum = 0;
+    for (auto& element : a[1].getArray()) {
+        sum += element.getInt32();
+    }
+    EXPECT_EQ(5, sum);
+
+    std::string keys;
+    for (auto& member : root.getObject()) {
+        keys += member.m_key.getString();
+    }
+    EXPECT_EQ("nfildsao", keys);
+}
+
+TEST(json_tape, large_container)
+{
+    // element count saturates in the tape word, getSize() then walks the container
+    const size_t n = (1 << 24) + 3;
+    std::string json = "[";
+    for (size_t i = 0; i < n; i++) {
+        json += i == 0 ? "0" : ",0";
+    }
+    json += "]";
+    TapeDocument doc;
+    EXPECT_EQ(PARSE_OK, doc.parse(json));
+    EXPECT_EQ(n, doc.root().getSize());
+    EXPECT_EQ(n + 2, doc.getTapeSize());
+}
+
+TEST(json_tape, reuse)
+{
+    TapeDocument doc;
+    EXPECT_EQ(PARSE_OK, doc.parse("[\"abc\",{\"k\":\"v\"}]"));
+    EXPECT_EQ(PARSE_OK, doc.parse("{\"x\":[true]}"));
+    EXPECT_TRUE(doc.root()["x"][0].getBool());
+    EXPECT_EQ(PARSE_MISS_KEY, doc.parse("{1}"));
+    EXPECT_EQ(PARSE_OK, doc.parse("\"s\""));
+    EXPECT_EQ("s", doc.root().getString());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
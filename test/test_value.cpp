@@ -1,4 +1,12 @@
 #include "cppjson/Document.hpp"
+#include "cppjson/KeyPool.hpp"
+#include "cppjson/MemoryPool.hpp"
+#include "cppjson/MemoryReadStream.hpp"
+#include "cppjson/MmapReadStream.hpp"
+#include "cppjson/StringWriteStream.hpp"
+#include "cppjson/Writer.hpp"
+#include <thread>
+#include <unistd.h>
 #include "gtest/gtest.h"
 
 
@@ -55,6 +63,23 @@ TEST(json_value, null) {
     TEST_NULL(" null ");
 }
 
+TEST(json_value, whitespace) {
+    // runs around the 16/32 byte vector widths, with and without a tail
+    const char blanks[] = " \t\r\n";
+    for (size_t n = 0; n < 100; n++) {
+        std::string ws;
+        for (size_t i = 0; i < n; i++) {
+            ws.push_back(blanks[i % 4]);
+        }
+        TEST_NULL(ws + "null" + ws);
+
+        cppjson::Document doc;
+        cppjson::ParseError err = doc.parse("[" + ws + "1" + ws + "," + ws + "2" + ws + "]" + ws);
+        EXPECT_EQ(err, cppjson::PARSE_OK);
+        EXPECT_EQ(doc.getSize(), 2);
+    }
+}
+
 TEST(json_value, bool_) {
     TEST_BOOL(cppjson::TYPE_BOOL, true, "true");
     TEST_BOOL(cppjson::TYPE_BOOL, true, "\r\ntrue ");
@@ -70,15 +95,23 @@ TEST(json_value, number) {
 /* https://en.wikipedia.org/wiki/Double-precision_floating-point_format */
     TEST_DOUBLE(1.0000000000000002, "1.0000000000000002");
     TEST_DOUBLE(-1.0000000000000002, "-1.0000000000000002");
-    // fixme stod not pass edge case
-//    TEST_DOUBLE(4.9406564584124654e-323, "4.9406564584124654E-323");
-//    TEST_DOUBLE(4.9406564584124654e-324, "4.9406564584124654e-324");
-//    TEST_DOUBLE(2.2250738585072009e-308, "2.2250738585072009e-308");
-//    TEST_DOUBLE(-2.2250738585072009e-308, "-2.2250738585072009e-308");
+    TEST_DOUBLE(4.9406564584124654e-323, "4.9406564584124654E-323");
+    TEST_DOUBLE(4.9406564584124654e-324, "4.9406564584124654e-324");
+    TEST_DOUBLE(2.2250738585072009e-308, "2.2250738585072009e-308");
+    TEST_DOUBLE(-2.2250738585072009e-308, "-2.2250738585072009e-308");
     TEST_DOUBLE(2.2250738585072014e-308, "2.2250738585072014e-308");
     TEST_DOUBLE(-2.2250738585072014e-308, "-2.2250738585072014e-308");
     TEST_DOUBLE(1.7976931348623157e308, "1.7976931348623157e308");
     TEST_DOUBLE(-1.7976931348623157e308, "-1.7976931348623157e308");
+    TEST_DOUBLE(1e23, "1e23");
+    TEST_DOUBLE(0.0, "1e-400");
+    TEST_DOUBLE(0.0, "0e99999999999999999999");
+    TEST_DOUBLE(3.141592653589793, "3.14159265358979323846264338327950288");
+    TEST_DOUBLE(9007199254740992.0, "9007199254740993.0");/* halfway, round to even */
+    TEST_DOUBLE(9007199254740994.0, "9007199254740993.0000000000000000001");
+    TEST_DOUBLE(0.1, "0.1000000000000000055511151231257827021181583404541015625");
+    TEST_DOUBLE(1.0, "0.99999999999999999999999999999999999");
+    TEST_DOUBLE(123456789012345678901234567890.0, "123456789012345678901234567890.0");
     TEST_DOUBLE(INFINITY, "Infinity");
     TEST_DOUBLE(NAN, "NaN");
 
@@ -113,6 +146,30 @@ TEST(json_value, number) {
     TEST_INT64(-2147483648, "-2147483648i64");
 }
 
+TEST(json_value, number_random)
+{
+    // every double must come back bit for bit from its shortest exact representation
+    uint64_t seed = 88172645463325252ULL;
+    for (int i = 0; i < 100000; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        double d;
+        memcpy(&d, &seed, sizeof(d));
+        if (std::isnan(d) || std::isinf(d)) {
+            continue;
+        }
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.17g", d);
+        if (strpbrk(buf, ".e") == nullptr) {
+            strcat(buf, ".0");
+        }
+        TEST_DOUBLE(d, buf);
+        snprintf(buf, sizeof(buf), "%.8e", d);//不是精确表示, 与strtod比较
+        TEST_DOUBLE(strtod(buf, nullptr), buf);
+    }
+}
+
 TEST(json_value, string_)
 {
     TEST_STRING("", "\"\"");
@@ -130,6 +187,22 @@ TEST(json_value, string_)
     TEST_STRING("\xF0\x9D\x84\x9E", "\"\\ud834\\udd1e\""); /* G clef  𝄞 */
 }
 
+TEST(json_value, long_string)
+{
+    // escapes on both sides of the 16/32 byte vector boundaries
+    for (size_t n = 0; n < 70; n++) {
+        std::string plain(n, 'x');
+        TEST_STRING(plain, "\"" + plain + "\"");
+        TEST_STRING(plain + "\n" + plain + "\"", "\"" + plain + "\\n" + plain + "\\\"\"");
+        TEST_STRING(plain + "\xE2\x82\xAC" + plain, "\"" + plain + "\\u20AC" + plain + "\"");
+
+        std::string json = "[\"" + plain + "\\t" + plain + "\"]";
+        cppjson::Document doc;
+        EXPECT_EQ(doc.parseInsitu(&json[0], json.size()), cppjson::PARSE_OK);
+        EXPECT_EQ(doc[0].getString(), plain + "\t" + plain);
+    }
+}
+
 TEST(json_value, array)
 {
     cppjson::ParseError err;
@@ -146,7 +219,7 @@ TEST(json_value, array)
         EXPECT_EQ(err, cppjson::PARSE_OK);
         EXPECT_EQ(doc.getType(), cppjson::TYPE_ARRAY);
 
-        auto& array = doc.getArray();
+        auto array = doc.getArray();
         EXPECT_EQ(array.size(), 1);
         EXPECT_EQ(array[0].getType(), cppjson::TYPE_ARRAY);
         EXPECT_TRUE(array[0].getArray().empty());
@@ -157,7 +230,7 @@ TEST(json_value, array)
         EXPECT_EQ(err, cppjson::PARSE_OK);
         EXPECT_EQ(doc.getType(), cppjson::TYPE_ARRAY);
 
-        auto& array = doc.getArray();
+        auto array = doc.getArray();
 
         EXPECT_EQ(5, array.size());
         for (size_t i = 0; i < array.size(); i++) {
@@ -171,7 +244,7 @@ TEST(json_value, array)
         EXPECT_EQ(err, cppjson::PARSE_OK);
         EXPECT_EQ(doc.getType(), cppjson::TYPE_ARRAY);
 
-        auto& array = doc.getArray();
+        auto array = doc.getArray();
 
         EXPECT_EQ(5, array.size());
         for (size_t i = 0; i < array.size(); i++) {
@@ -185,7 +258,7 @@ TEST(json_value, array)
         EXPECT_EQ(err, cppjson::PARSE_OK);
         EXPECT_EQ(doc.getType(), cppjson::TYPE_ARRAY);
 
-        auto& array = doc.getArray();
+        auto array = doc.getArray();
         EXPECT_EQ(5, array.size());
         EXPECT_EQ(array[0].getType(), cppjson::TYPE_STRING);
         EXPECT_EQ(array[1].getType(), cppjson::TYPE_BOOL);
@@ -229,7 +302,7 @@ TEST(json_value, object)
     EXPECT_EQ(doc["i"].getInt32(), 123);
     EXPECT_EQ(doc["s"].getString(), "abc");
 
-    auto& array = doc["a"].getArray();
+    auto array = doc["a"].getArray();
     EXPECT_EQ(array.size(), 3);
     for (size_t i = 0; i < 3; i++) {
         EXPECT_EQ(array[i].getType(), cppjson::TYPE_INT32);
@@ -243,6 +316,671 @@ TEST(json_value, object)
     EXPECT_EQ(obj["3"].getInt32(), 3);
 }
 
+TEST(json_value, insitu)
+{
+    char json[] = "{ \"name\" : \"he\\nhe\", \"a\" : [ \"\\u20AC\", \"\\uD834\\uDD1E\", 1 ] }";
+    cppjson::Document doc;
+    cppjson::ParseError err = doc.parseInsitu(json);
+    EXPECT_EQ(err, cppjson::PARSE_OK);
+    EXPECT_EQ(doc["name"].getString(), "he\nhe");
+    EXPECT_EQ(doc["a"][0].getString(), "\xE2\x82\xAC");
+    EXPECT_EQ(doc["a"][1].getString(), "\xF0\x9D\x84\x9E");
+    EXPECT_EQ(doc["a"][2].getInt32(), 1);
+
+    // strings are decoded in place and null terminated
+    EXPECT_STREQ(json + 3, "name");
+    EXPECT_STREQ(json + 12, "he\nhe");
+
+    // copies of a borrowed string still refer to the buffer
+    cppjson::Value copy(doc["name"]);
+    EXPECT_EQ(copy.getString(), "he\nhe");
+}
+
+TEST(json_value, insitu_error)
+{
+    char json1[] = "[\"abc";
+    cppjson::Document doc1;
+    EXPECT_EQ(doc1.parseInsitu(json1), cppjson::PARSE_MISS_QUOTATION_MARK);
+
+    char json2[] = "[\"\\x\"]";
+    cppjson::Document doc2;
+    EXPECT_EQ(doc2.parseInsitu(json2), cppjson::PARSE_BAD_STRING_ESCAPE);
+}
+
+static std::string writeTempFile(const std::string& content) {
+    char path[] = "/tmp/cppjson_test_XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT_GE(fd, 0);
+    EXPECT_EQ(write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+    close(fd);
+    return path;
+}
+
+TEST(json_value, mmap)
+{
+    std::string path = writeTempFile("{ \"name\" : \"he\\nhe\", \"a\" : [ \"plain\", 1.5, true ] }");
+    {
+        cppjson::MmapReadStream is(path.c_str());
+        EXPECT_TRUE(is.good());
+        cppjson::Document doc;
+        EXPECT_EQ(doc.parseStream(is), cppjson::PARSE_OK);
+        EXPECT_EQ(doc["name"].getString(), "he\nhe");
+        EXPECT_EQ(doc["a"][0].getString(), "plain");
+        EXPECT_EQ(doc["a"][1].getDouble(), 1.5);
+    }
+    {
+        // the document borrows "plain" (and the keys) from the mapping, so it goes out of scope first
+        cppjson::MmapReadStream is(path.c_str(), true);
+        cppjson::Document doc;
+        EXPECT_EQ(doc.parseStream(is), cppjson::PARSE_OK);
+        EXPECT_EQ(doc["name"].getString(), "he\nhe");
+        EXPECT_EQ(doc["a"][0].getString(), "plain");
+        EXPECT_TRUE(doc["a"][2].getBool());
+    }
+
+    std::string empty = writeTempFile("");
+    cppjson::MmapReadStream is(empty.c_str());
+    EXPECT_TRUE(is.good());
+    cppjson::Document doc;
+    EXPECT_EQ(doc.parseStream(is), cppjson::PARSE_EXPECT_VALUE);
+    EXPECT_FALSE(cppjson::MmapReadStream("/nonexistent/cppjson.json").good());
+    EXPECT_FALSE(cppjson::MmapReadStream("/dev/null").good());//不是普通文件
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    FILE* readEnd = fdopen(fds[0], "r");
+    EXPECT_FALSE(cppjson::MmapReadStream(readEnd).good());
+    fclose(readEnd);
+    close(fds[1]);
+
+    // a FILE is read from its current position on, and the position isn't moved
+    std::string prefixed = writeTempFile("xyz [ \"plain\", 2 ]");
+    FILE* fp = fopen(prefixed.c_str(), "r");
+    ASSERT_NE(nullptr, fp);
+    ASSERT_EQ(0, fseek(fp, 4, SEEK_SET));
+    {
+        cppjson::MmapReadStream tail(fp, true);
+        EXPECT_TRUE(tail.good());
+        cppjson::Document doc;
+        EXPECT_EQ(doc.parseStream(tail), cppjson::PARSE_OK);
+        EXPECT_EQ(doc[0].getString(), "plain");
+        EXPECT_EQ(doc[1].getInt32(), 2);
+        EXPECT_EQ(4, ftell(fp));
+    }
+    rewind(fp);
+    {
+        cppjson::MmapReadStream whole(fp);
+        cppjson::Document doc;
+        EXPECT_EQ(doc.parseStream(whole), cppjson::PARSE_BAD_VALUE);
+    }
+    ASSERT_EQ(0, fseek(fp, 0, SEEK_END));
+    {
+        cppjson::MmapReadStream none(fp);
+        EXPECT_TRUE(none.good());
+        cppjson::Document doc;
+        EXPECT_EQ(doc.parseStream(none), cppjson::PARSE_EXPECT_VALUE);
+    }
+    fclose(fp);
+    unlink(prefixed.c_str());
+    unlink(path.c_str());
+    unlink(empty.c_str());
+}
+
+TEST(json_value, reparse)
+{
+    // a document can be parsed into again, also after an error
+    cppjson::Document doc;
+    EXPECT_EQ(doc.parse("[1, {\"a\": 2"), cppjson::PARSE_MISS_COMMA_OR_CURLY_BRACKET);
+    EXPECT_EQ(doc.parse("{\"b\": [true]}"), cppjson::PARSE_OK);
+    EXPECT_EQ(doc.getSize(), 1u);
+    EXPECT_TRUE(doc["b"][0].getBool());
+    EXPECT_EQ(doc.parse("\"s\"", 3), cppjson::PARSE_OK);
+    EXPECT_EQ(doc.getString(), "s");
+}
+
+TEST(json_value, short_string)
+{
+    // around Value::kShortCapacity, kept in the Value or on the heap
+    for (size_t len = 0; len <= cppjson::Value::kShortCapacity + 2; len++) {
+        std::string str;
+        for (size_t i = 0; i < len; i++) {
+            str.push_back(static_cast<char>('a' + i));
+        }
+        cppjson::Value value(str);
+        EXPECT_EQ(value.getString(), str);
+        EXPECT_EQ(value.getStringLength(), len);
+
+        cppjson::Value copy(value);
+        cppjson::Value moved(std::move(value));
+        EXPECT_TRUE(value.isNull());
+        EXPECT_EQ(copy.getString(), str);
+        EXPECT_EQ(moved.getString(), str);
+        copy = moved;
+        moved.setString(str + str);
+        EXPECT_EQ(copy.getString(), str);
+        EXPECT_EQ(moved.getString(), str + str);
+
+        cppjson::Document doc;
+        EXPECT_EQ(doc.parse("{\"" + str + "\": [\"" + str + "\"]}"), cppjson::PARSE_OK);
+        EXPECT_EQ(doc.getObject()[0].m_key.getString(), str);
+        EXPECT_EQ(doc[str][0].getString(), str);
+    }
+    EXPECT_EQ(cppjson::Value(cppjson::TYPE_STRING).getString(), "");
+
+    // an in-situ document keeps its short strings itself
+    char json[] = "[\"ab\", \"a string longer than 14\"]";
+    cppjson::Document doc;
+    EXPECT_EQ(doc.parseInsitu(json), cppjson::PARSE_OK);
+    EXPECT_NE(doc[0].getStringData(), json + 2);
+    EXPECT_EQ(doc[1].getStringData(), json + 8);
+    EXPECT_EQ(doc[1].getString(), "a string longer than 14");
+}
+
+TEST(json_value, elements)
+{
+    static_assert(sizeof(cppjson::Value) == 16, "compact Value");
+    static_assert(sizeof(cppjson::Member) == 32, "compact Member");
+
+    cppjson::Value value(cppjson::TYPE_ARRAY);
+    auto array = value.getArray();
+    EXPECT_TRUE(array.empty());
+    EXPECT_EQ(array.capacity(), 0u);//没有元素时不分配
+    for (int32_t i = 0; i < 100; i++) {
+        array.push_back(cppjson::Value(i));
+    }
+    array.push_back(array[0]);//growing with an element of the old block
+    EXPECT_EQ(value.getSize(), 101u);
+    EXPECT_EQ(array.back().getInt32(), 0);
+    array.pop_back();
+    array.resize(200);
+    EXPECT_TRUE(array[150].isNull());
+    array.resize(50);
+    array.reserve(1000);
+    EXPECT_EQ(array.capacity(), 1000u);
+    EXPECT_EQ(array.size(), 50u);
+    int32_t sum = 0;
+    for (auto& element : value.getArray()) {
+        sum += element.getInt32();
+    }
+    EXPECT_EQ(sum, 49 * 50 / 2);
+
+    cppjson::Value copy(value);
+    array.clear();//value先有了自己的块(刚好大小), copy留着共享的那个
+    EXPECT_EQ(value.getSize(), 0u);
+    EXPECT_EQ(copy.getSize(), 50u);
+    EXPECT_EQ(copy.getArray().capacity(), 1000u);
+    EXPECT_EQ(copy[49].getInt32(), 49);
+
+    // a pooled array or object moves to the heap when it grows
+    cppjson::Document doc;
+    EXPECT_EQ(doc.parse("{\"a\": [1, 2], \"b\": {\"c\": \"a string longer than 14\"}}"), cppjson::PARSE_OK);
+    EXPECT_EQ(doc["a"].getArray().capacity(), 2u);
+    doc["a"].addValue(cppjson::Value("x"));
+    doc["a"].addValue(doc["b"]);
+    doc.addMember(cppjson::Value("d"), cppjson::Value(true));
+    EXPECT_EQ(doc.getSize(), 3u);
+    EXPECT_EQ(doc["a"][1].getInt32(), 2);
+    EXPECT_EQ(doc["a"][2].getString(), "x");
+    EXPECT_EQ(doc["a"][3]["c"].getString(), "a string longer than 14");
+    EXPECT_TRUE(doc["d"].getBool());
+    EXPECT_EQ(doc.findMember("e"), doc.getObject().end());
+
+    // an object grows by copies of a member, shrinks and clears without one
+    cppjson::Value::Object object = doc.getObject();
+    object.resize(5, cppjson::Member(cppjson::Value("e"), cppjson::Value("a string longer than 14")));
+    EXPECT_EQ(doc.getSize(), 5u);
+    EXPECT_EQ(doc["e"].getString(), "a string longer than 14");
+    EXPECT_EQ(object[4].m_key.getString(), "e");
+    object.resize(6, object[0]);//a member of the object itself
+    EXPECT_EQ(object[5].m_key.getString(), "a");
+    EXPECT_EQ(doc["a"].getSize(), 4u);
+    object.resize(2, object[0]);
+    EXPECT_EQ(doc.getSize(), 2u);
+    EXPECT_EQ(doc.findMember("d"), object.end());
+    EXPECT_EQ(doc["b"]["c"].getString(), "a string longer than 14");
+    cppjson::Value shared(doc);
+    doc.getObject().clear();
+    EXPECT_EQ(doc.getSize(), 0u);
+    EXPECT_EQ(doc.findMember("a"), doc.getObject().end());
+    EXPECT_EQ(shared.getSize(), 2u);
+    doc.addMember(cppjson::Value("f"), cppjson::Value(1));
+    EXPECT_EQ(doc["f"].getInt32(), 1);
+
+    // a pooled object cleared in place
+    ASSERT_EQ(doc.parse("{\"a\": {\"b\": [\"a string longer than 14\"]}}"), cppjson::PARSE_OK);
+    doc["a"].getObject().clear();
+    EXPECT_EQ(doc["a"].getSize(), 0u);
+    doc["a"].addMember(cppjson::Value("c"), cppjson::Value(2));
+    EXPECT_EQ(doc["a"]["c"].getInt32(), 2);
+}
+
+TEST(json_value, member_index)
+{
+    // below and above Value::kIndexThreshold, parsed and built by hand
+    for (size_t n : {size_t(3), size_t(cppjson::Value::kIndexThreshold), size_t(5000)}) {
+        std::string json = "{";
+        cppjson::Value built(cppjson::TYPE_OBJECT);
+        for (size_t i = 0; i < n; i++) {
+            std::string key = "key_" + std::to_string(i) + (i % 3 ? "" : "_a_longer_key_name");
+            json += (i ? "," : "") + ("\"" + key + "\":") + std::to_string(i);
+            built.addMember(cppjson::Value(key), cppjson::Value(static_cast<int32_t>(i)));
+        }
+        json += ",\"key_0_a_longer_key_name\":-1}";//重复的键: the first one is found
+        cppjson::Document doc;
+        ASSERT_EQ(doc.parse(json), cppjson::PARSE_OK);
+        cppjson::Value copy(doc);
+        cppjson::Value& parsed = doc;
+        for (cppjson::Value* value : {&parsed, &built, &copy}) {
+            for (size_t i = 0; i < n; i++) {
+                std::string key = "key_" + std::to_string(i) + (i % 3 ? "" : "_a_longer_key_name");
+                ASSERT_EQ((*value)[key].getInt32(), static_cast<int32_t>(i)) << key;
+            }
+            EXPECT_EQ(value->findMember("key_"), value->getObject().end());
+            EXPECT_EQ(value->findMember("key_1_a_longer_key_name"), value->getObject().end());
+        }
+
+        // removing the last members keeps the index in step
+        auto object = doc.getObject();
+        object.pop_back();
+        object.pop_back();
+        EXPECT_EQ(doc.findMember(n % 3 == 1 ? "key_" + std::to_string(n - 1) + "_a_longer_key_name"
+                                            : "key_" + std::to_string(n - 1)), object.end());
+        EXPECT_EQ(doc["key_0_a_longer_key_name"].getInt32(), 0);
+        doc.addMember(cppjson::Value("new"), cppjson::Value(true));
+        EXPECT_TRUE(doc["new"].getBool());
+        EXPECT_EQ(doc["key_1"].getInt32(), 1);
+    }
+}
+
+TEST(json_value, string_ref)
+{
+    cppjson::Document doc;
+    std::string json = "{\"field\": \"a value longer than 14 bytes\", \"k\\u0000ey\": 1, \"id\": \"x\"}";
+    ASSERT_EQ(doc.parse(json), cppjson::PARSE_OK);
+
+    // the key as a literal, a std::string or a StringRef, none is copied
+    EXPECT_EQ(doc["field"].getStringRef(), "a value longer than 14 bytes");
+    EXPECT_EQ(doc[std::string("id")].getStringRef(), "x");
+    EXPECT_EQ(doc[cppjson::StringRef("k\0ey", 4)].getInt32(), 1);
+    EXPECT_EQ(doc.findMember("k"), doc.getObject().end());
+    cppjson::StringRef ref = doc["field"].getStringRef();
+    EXPECT_EQ(ref.data(), doc["field"].getStringData());
+    EXPECT_EQ(ref.size(), 28u);
+#if __cplusplus >= 201703L
+    EXPECT_EQ(doc["id"].getStringView(), std::string_view("x"));
+    EXPECT_EQ(doc[std::string_view("id")].getStringRef(), "x");
+#endif
+
+    // a part of its own string
+    cppjson::Value& field = doc["field"];
+    field.setString(cppjson::StringRef(field.getStringData() + 2, 5));
+    EXPECT_EQ(field.getString(), "value");
+    field.setString("another value longer than 14 bytes");
+    field.setString(cppjson::StringRef(field.getStringData() + 8, 20));
+    EXPECT_EQ(field.getString(), "value longer than 14");
+
+    // the buffer is taken over, short ones are copied
+    for (size_t len : {size_t(3), size_t(40)}) {
+        std::unique_ptr<char[]> buffer(new char[len]);
+        memset(buffer.get(), 'z', len);
+        const char* p = buffer.get();
+        cppjson::Value adopted(std::move(buffer), len);
+        EXPECT_EQ(adopted.getString(), std::string(len, 'z'));
+        EXPECT_EQ(adopted.getStringData() == p, len > cppjson::Value::kShortCapacity);
+    }
+    std::unique_ptr<char[]> buffer(new char[20]);
+    memcpy(buffer.get(), "twenty bytes of text", 20);
+    doc["id"].setString(std::move(buffer), 20);
+    EXPECT_EQ(doc["id"].getStringRef(), "twenty bytes of text");
+
+    // moved in, reserved
+    cppjson::Value object(cppjson::TYPE_OBJECT);
+    object.reserve(100);
+    EXPECT_EQ(object.getObject().capacity(), 100u);
+    cppjson::Value key("name");
+    cppjson::Value value("a string value that is moved");
+    object.addMember(std::move(key), std::move(value));
+    EXPECT_TRUE(key.isNull());
+    EXPECT_TRUE(value.isNull());
+    EXPECT_EQ(object["name"].getStringRef(), "a string value that is moved");
+    cppjson::Value array(cppjson::TYPE_ARRAY);
+    array.reserve(10);
+    EXPECT_EQ(array.getArray().capacity(), 10u);
+}
+
+TEST(json_value, key_pool)
+{
+    auto keys = std::make_shared<cppjson::KeyPool>();
+    std::string s = "a key longer than 14 bytes";
+    const char* p = keys->intern(s.data(), s.size());
+    EXPECT_NE(p, s.data());
+    const char* again = keys->intern(std::string(s).data(), s.size());
+    EXPECT_EQ(again, p);
+    cppjson::KeyPool::release(again);
+    EXPECT_EQ(cppjson::KeyPool::hashOf(p), cppjson::Value::hashKey(s.data(), s.size()));
+    EXPECT_EQ(cppjson::KeyPool::lengthOf(p), s.size());
+    EXPECT_EQ(keys->size(), 1u);
+    EXPECT_EQ(keys->purge(), 0u);//p is still held
+    cppjson::KeyPool::release(p);
+    EXPECT_EQ(keys->purge(), 1u);
+    EXPECT_EQ(keys->size(), 0u);
+    p = keys->intern(s.data(), s.size());
+
+    // records with more than kIndexThreshold members, more distinct keys than the cache of a document has slots;
+    // record r has the keys r * 15 .. r * 15 + 29
+    auto keyOf = [](size_t n) { return std::string(n % 2 ? "field_" : "fld_") + std::to_string(n) + "_of_a_record"; };
+    std::string json = "[";
+    for (size_t r = 0; r < 20; r++) {
+        json += r ? ",{" : "{";
+        for (size_t i = 0; i < 30; i++) {
+            json += (i ? ",\"" : "\"") + keyOf(r * 15 + i) + "\":" + std::to_string(i);
+        }
+        json += ",\"id\":" + std::to_string(r) + "}";
+    }
+    json += "]";
+    cppjson::Value copy;
+    {
+        cppjson::Document a, b;
+        a.setKeyPool(keys);
+        b.setKeyPool(keys);
+        ASSERT_EQ(a.parse(json), cppjson::PARSE_OK);
+        ASSERT_EQ(b.parse(json), cppjson::PARSE_OK);
+        EXPECT_EQ(keys->size(), 1u + 20 * 15 + 15);
+        for (size_t r = 0; r < 20; r++) {
+            for (size_t i = 0; i < 30; i++) {
+                std::string key = keyOf(r * 15 + i);
+                ASSERT_EQ(a[r][key].getInt32(), static_cast<int32_t>(i)) << key;
+                EXPECT_EQ(a[r].findMember(key)->m_key.getStringData(), b[r].findMember(key)->m_key.getStringData());
+                const char* interned = keys->intern(key.data(), key.size());
+                EXPECT_EQ(b[r][interned].getInt32(), static_cast<int32_t>(i));
+                cppjson::KeyPool::release(interned);
+            }
+            EXPECT_EQ(a[r]["id"].getInt32(), static_cast<int32_t>(r));
+        }
+        EXPECT_EQ(a[1].getObject()[0].m_key.getStringData(), a[0].getObject()[15].m_key.getStringData());
+        EXPECT_EQ(a[0].findMember("fld_0_of_a_record_"), a[0].getObject().end());
+        copy = a;
+        // a copy keeps the interned keys
+        const cppjson::Value& constCopy = copy;
+        EXPECT_EQ(constCopy[3].getObject()[7].m_key.getStringData(), a[3].getObject()[7].m_key.getStringData());
+    }
+    // the keys only the documents used are freed, those of the copy stay
+    EXPECT_EQ(keys->purge(), 0u);
+    copy[19].setNull();
+    EXPECT_EQ(keys->purge(), 15u);
+    EXPECT_EQ(copy[18]["fld_270_of_a_record"].getInt32(), 0);
+    copy[18].addMember(cppjson::Value("a new key of the copy"), cppjson::Value(true));
+    EXPECT_TRUE(copy[18]["a new key of the copy"].getBool());
+    keys.reset();//they outlive the pool
+    EXPECT_EQ(copy[0]["fld_0_of_a_record"].getInt32(), 0);
+    copy.setNull();
+    cppjson::KeyPool::release(p);
+
+    // keys that come and go do not pile up
+    keys = std::make_shared<cppjson::KeyPool>();
+    for (int round = 0; round < 50; round++) {
+        cppjson::Document doc;
+        doc.setKeyPool(keys);
+        std::string record = "{";
+        for (int i = 0; i < 100; i++) {
+            record += (i ? ",\"" : "\"") + std::string("a unique key number ") + std::to_string(round * 100 + i) + "\":1";
+        }
+        ASSERT_EQ(doc.parse(record + "}"), cppjson::PARSE_OK);
+    }
+    EXPECT_LE(keys->size(), 400u);
+}
+
+TEST(json_value, copy_on_write)
+{
+    cppjson::Value config(cppjson::TYPE_OBJECT);
+    config.addMember(cppjson::Value("name"), cppjson::Value("a string longer than 14 bytes"));
+    config.addMember(cppjson::Value("list"), cppjson::Value(cppjson::TYPE_ARRAY));
+    for (int32_t i = 0; i < 100; i++) {
+        config["list"].addValue(cppjson::Value(i));
+    }
+    const cppjson::Value& original = config;
+
+    // a copy shares the strings and elements, reading it through const keeps them shared
+    cppjson::Value copy(config);
+    const cppjson::Value& shared = copy;
+    EXPECT_EQ(shared.getObject().data(), original.getObject().data());
+    EXPECT_EQ(shared["name"].getStringData(), original["name"].getStringData());
+    EXPECT_EQ(shared["list"][99].getInt32(), 99);
+    EXPECT_EQ(shared.getObject().data(), original.getObject().data());
+
+    // writing it out reads it through const too
+    cppjson::StringWriteStream os;
+    cppjson::Writer<cppjson::StringWriteStream> writer(os);
+    EXPECT_TRUE(writer.fromValue(copy));
+    EXPECT_EQ(os.get().substr(0, 50), "{\"name\":\"a string longer than 14 bytes\",\"list\":[0,");
+    EXPECT_EQ(shared.getObject().data(), original.getObject().data());
+    EXPECT_EQ(shared["list"].getArray().data(), original["list"].getArray().data());
+
+    // the first change copies one level, what is not changed is still shared
+    copy["list"][0].setInt32(-1);
+    EXPECT_NE(shared.getObject().data(), original.getObject().data());
+    EXPECT_NE(shared["list"].getArray().data(), original["list"].getArray().data());
+    EXPECT_EQ(shared["name"].getStringData(), original["name"].getStringData());
+    EXPECT_EQ(original["list"][0].getInt32(), 0);
+    EXPECT_EQ(shared["list"][0].getInt32(), -1);
+    copy.addMember(cppjson::Value("added"), cppjson::Value(true));
+    EXPECT_EQ(original.getSize(), 2u);
+    EXPECT_EQ(copy.getSize(), 3u);
+    config.setNull();
+    EXPECT_EQ(shared["name"].getString(), "a string longer than 14 bytes");
+    EXPECT_EQ(shared["list"][1].getInt32(), 1);
+
+    // a document's blocks are shared with its copies, which keep its pool: they outlive the document and its next parse
+    cppjson::Document doc;
+    ASSERT_EQ(doc.parse("{\"a\": [\"a string longer than 14 bytes\", {}]}"), cppjson::PARSE_OK);
+    cppjson::Value first(doc);
+    cppjson::Value second(first);
+    const cppjson::Value& constDoc = doc;
+    const cppjson::Value& constFirst = first;
+    const cppjson::Value& constSecond = second;
+    EXPECT_EQ(constFirst.getObject().data(), constDoc.getObject().data());
+    EXPECT_EQ(constFirst["a"][0].getStringData(), constDoc["a"][0].getStringData());
+    EXPECT_EQ(constFirst["a"][0].getStringData(), constSecond["a"][0].getStringData());
+    ASSERT_EQ(doc.parse("[\"another string longer than 14 bytes\"]"), cppjson::PARSE_OK);
+    EXPECT_EQ(constFirst["a"][0].getString(), "a string longer than 14 bytes");
+    doc.setNull();
+    EXPECT_EQ(constSecond["a"][0].getString(), "a string longer than 14 bytes");
+    first.setNull();
+    EXPECT_EQ(constSecond["a"].getSize(), 2u);
+
+    // what a heap block holds from a pool keeps the pool: grown out of the pool or moved into a heap array
+    cppjson::Value grown, moved(cppjson::TYPE_ARRAY);
+    {
+        cppjson::Document pooled;
+        ASSERT_EQ(pooled.parse("[[\"a string longer than 14 bytes\",2,3],{\"key longer than 14 bytes\":[1]}]"), cppjson::PARSE_OK);
+        pooled.getArray().push_back(cppjson::Value(1));
+        moved.addValue(std::move(pooled[1]));
+        grown = pooled;
+        pooled.parse("{}");
+    }
+    EXPECT_EQ(grown[0][0].getString(), "a string longer than 14 bytes");
+    EXPECT_EQ(grown.getSize(), 3u);
+    EXPECT_EQ(moved[0]["key longer than 14 bytes"][0].getInt32(), 1);
+    cppjson::Value movedCopy(moved);
+    EXPECT_EQ(movedCopy[0].getObject()[0].m_key.getStringRef(), "key longer than 14 bytes");
+
+    // a view taken before the document was copied detaches it when written through, the copy keeps the parsed elements
+    cppjson::Document parsed;
+    ASSERT_EQ(parsed.parse("[1, [2, 3], \"a string longer than 14 bytes\"]"), cppjson::PARSE_OK);
+    cppjson::Value::Array stale = parsed.getArray();
+    cppjson::Value snapshot(parsed);
+    const cppjson::Value& constParsed = parsed;
+    const cppjson::Value& constSnapshot = snapshot;
+    stale[0].setInt32(-1);
+    stale.push_back(cppjson::Value(4));
+    EXPECT_EQ(constSnapshot[0].getInt32(), 1);
+    EXPECT_EQ(constSnapshot.getSize(), 3u);
+    EXPECT_EQ(constParsed[0].getInt32(), -1);
+    EXPECT_EQ(constParsed.getSize(), 4u);
+    EXPECT_EQ(constSnapshot[1].getArray().data(), constParsed[1].getArray().data());
+
+    // copies of it changed and dropped on several threads while the document parses again
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&constSnapshot, t] {
+            for (int i = 0; i < 200; i++) {
+                cppjson::Value mine(constSnapshot);
+                mine[1][0].setInt32(t);
+                mine.addValue(cppjson::Value(i));
+                ASSERT_EQ(mine.getSize(), 4u);
+                ASSERT_EQ(mine[2].getStringRef(), "a string longer than 14 bytes");
+            }
+        });
+    }
+    for (int i = 0; i < 200; i++) {
+        ASSERT_EQ(parsed.parse("[[5, 6], \"another string longer than 14 bytes\"]"), cppjson::PARSE_OK);
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(constSnapshot[1][0].getInt32(), 2);
+
+    // an adopted buffer is copied
+    std::unique_ptr<char[]> buffer(new char[20]);
+    memcpy(buffer.get(), "twenty bytes of text", 20);
+    cppjson::Value adopted(std::move(buffer), 20);
+    cppjson::Value adoptedCopy(adopted);
+    EXPECT_NE(adoptedCopy.getStringData(), adopted.getStringData());
+    EXPECT_EQ(adoptedCopy.getStringRef(), "twenty bytes of text");
+
+    // copies changed and dropped on several threads
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&shared, t] {
+            for (int i = 0; i < 200; i++) {
+                cppjson::Value mine(shared);
+                mine["list"][t].setInt32(t);
+                mine["list"].addValue(cppjson::Value(i));
+                ASSERT_EQ(mine["list"].getSize(), 101u);
+                ASSERT_EQ(mine["name"].getStringRef(), "a string longer than 14 bytes");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(shared["list"][0].getInt32(), -1);
+    EXPECT_EQ(shared["list"].getSize(), 100u);
+}
+
+TEST(json_value, memory_pool)
+{
+    cppjson::MemoryPool pool(1024);
+    EXPECT_EQ(pool.getReserved(), 0u);
+    char* a = static_cast<char*>(pool.allocate(3, 1));
+    double* d = static_cast<double*>(pool.allocate(sizeof(double), alignof(double)));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(d) % alignof(double), 0u);
+    EXPECT_EQ(pool.getUsed(), 3 + sizeof(double));
+    EXPECT_EQ(pool.getReserved(), 1024u);
+    memcpy(a, "abc", 3);
+    *d = 1.5;
+    pool.allocate(4000);//大块单独一个chunk
+    EXPECT_EQ(pool.getReserved(), 1024u + 4000 + alignof(std::max_align_t));
+    EXPECT_EQ(*d, 1.5);
+    EXPECT_EQ(memcmp(a, "abc", 3), 0);
+
+    cppjson::MemoryPool other(1024);
+    other.allocate(100);
+    pool.splice(other);
+    EXPECT_EQ(pool.getUsed(), 3 + sizeof(double) + 4000 + 100);
+    EXPECT_EQ(other.getReserved(), 0u);
+    EXPECT_EQ(other.getUsed(), 0u);
+
+    pool.clear();
+    EXPECT_EQ(pool.getUsed(), 0u);
+    EXPECT_EQ(pool.getReserved(), 1024u);//第一个chunk留着
+}
+
+TEST(json_value, document_pool)
+{
+    std::string json = "{\"name\": \"a string longer than eight bytes\", \"tags\": [\"x\", \"y\", [1, 2.5, {}]], \"e\": \"\\n\"}";
+    cppjson::Document doc(256);
+    EXPECT_EQ(doc.parse(json), cppjson::PARSE_OK);
+    size_t used = doc.getUsedBytes();
+    EXPECT_GT(used, 0u);
+    EXPECT_GE(doc.getReservedBytes(), used);
+    EXPECT_EQ(doc["name"].getString(), "a string longer than eight bytes");
+    EXPECT_EQ(doc["tags"].getSize(), 3u);
+    EXPECT_EQ(doc["tags"][2][1].getDouble(), 2.5);
+    EXPECT_EQ(doc["e"].getString(), "\n");
+
+    // a copy does not refer to the pool
+    cppjson::Value copy(doc["tags"]);
+    cppjson::Value name(doc["name"]);
+    EXPECT_EQ(doc.parse("[1, 2, 3]"), cppjson::PARSE_OK);
+    EXPECT_LT(doc.getUsedBytes(), used);
+    EXPECT_EQ(copy[1].getString(), "y");
+    EXPECT_EQ(copy[2][0].getInt32(), 1);
+    EXPECT_EQ(name.getString(), "a string longer than eight bytes");
+
+    // values set into a pooled tree are released with it
+    doc[1].setString("a heap string, not from the pool");
+    doc.getArray().push_back(copy);
+    EXPECT_EQ(doc.getSize(), 4u);
+    EXPECT_EQ(doc[3][0].getString(), "x");
+    EXPECT_EQ(doc[1].getString(), "a heap string, not from the pool");
+}
+
+// moved out of a document, a subtree leaves the pool and outlives the document
+TEST(json_value, document_move)
+{
+    std::string json = "{\"items\": [{\"name\": \"a string longer than 14 bytes\", \"n\": 123456789012}, [\"another long string\"]],"
+                       " \"title\": \"the title of the document\"}";
+    cppjson::Value items, title, array(cppjson::TYPE_ARRAY), root;
+    {
+        auto keys = std::make_shared<cppjson::KeyPool>();
+        cppjson::Document doc;
+        doc.setKeyPool(keys);
+        cppjson::MemoryReadStream is(json.data(), json.size());
+        ASSERT_EQ(doc.parseStream<cppjson::kParseDefault | cppjson::kParseRawNumbers>(is), cppjson::PARSE_OK);
+        array.addValue(std::move(doc["items"][1]));//into a heap array
+        items = std::move(doc["items"]);
+        EXPECT_TRUE(doc["items"].isNull());
+        cppjson::Value moved(std::move(doc["title"]));
+        title = std::move(moved);
+        ASSERT_EQ(doc.parse(json), cppjson::PARSE_OK);
+        root = std::move(doc);
+    }
+    EXPECT_EQ(items[0]["name"].getString(), "a string longer than 14 bytes");
+    EXPECT_EQ(items[0]["n"].getInt64(), 123456789012LL);
+    EXPECT_TRUE(items[1].isNull());
+    EXPECT_EQ(title.getString(), "the title of the document");
+    EXPECT_EQ(root["items"][1][0].getString(), "another long string");
+    EXPECT_EQ(array[0][0].getString(), "another long string");
+    items.getArray().push_back(cppjson::Value("grown after the document is gone"));
+    EXPECT_EQ(items.getSize(), 3u);
+
+    // an element moved onto its own array
+    cppjson::Document doc;
+    ASSERT_EQ(doc.parse("[[\"a string longer than 14 bytes\"], 2]"), cppjson::PARSE_OK);
+    static_cast<cppjson::Value&>(doc) = std::move(doc[0]);
+    EXPECT_EQ(doc[0].getString(), "a string longer than 14 bytes");
+}
+
+// a document copies like a Value: deep out of the pool, it shares the KeyPool
+TEST(json_value, document_copy)
+{
+    auto keys = std::make_shared<cppjson::KeyPool>();
+    cppjson::Document doc;
+    doc.setKeyPool(keys);
+    ASSERT_EQ(doc.parse("{\"a key longer than 14 bytes\": [\"a string longer than 14 bytes\", 1]}"), cppjson::PARSE_OK);
+    cppjson::Document copy(doc);
+    EXPECT_EQ(copy.getKeyPool(), keys);
+    cppjson::Document assigned;
+    assigned = doc;
+    ASSERT_EQ(doc.parse("[]"), cppjson::PARSE_OK);
+    EXPECT_EQ(copy["a key longer than 14 bytes"][0].getString(), "a string longer than 14 bytes");
+    EXPECT_EQ(assigned["a key longer than 14 bytes"][1].getInt32(), 1);
+    EXPECT_EQ(assigned.getUsedBytes(), 0u);
+    ASSERT_EQ(copy.parse("[\"parsed into the copy\"]"), cppjson::PARSE_OK);
+    EXPECT_EQ(copy[0].getString(), "parsed into the copy");
+    assigned = assigned;
+    EXPECT_EQ(assigned["a key longer than 14 bytes"].getSize(), 2u);
+}
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);